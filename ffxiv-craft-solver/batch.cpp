@@ -0,0 +1,172 @@
+#include "batch.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include "action_enum.hpp"
+#include "timer.hpp"
+#include "work_stealing_pool.hpp"
+#include "portfolio.hpp"
+
+
+bool readBatchJobs(const char* path, std::vector<BatchJob>& jobs) {
+	FILE* f = fopen(path, "r");
+	if (!f) {
+		return false;
+	}
+	char buf[512];
+	int line = 0;
+	bool ok = true;
+	while (fgets(buf, sizeof(buf), f)) {
+		++line;
+		const char* s = buf + strspn(buf, " \t");
+		if (*s == '#' || *s == '\r' || *s == '\n' || *s == '\0') {
+			continue;
+		}
+		BatchJob job = { .line = line };
+		char name[128] = "";
+		// Decimal only, like recipes.txt, so a leading zero isn't read as octal
+		int n = sscanf(s, "%d %d %d %d %d %d %127[^\r\n]",
+			&job.ctx.base_progress_increase, &job.ctx.base_quality_increase,
+			&job.ctx.target_progress, &job.ctx.target_quality, &job.ctx.max_durability, &job.ctx.max_cp,
+			name
+		);
+		if (n < 6) {
+			printf("%s:%i: expected 6 numbers\n", path, line);
+			ok = false;
+			continue;
+		}
+		job.name = name;
+		jobs.push_back(job);
+	}
+	fclose(f);
+	return ok;
+}
+
+static void writeJsonString(FILE* f, const char* s) {
+	fputc('"', f);
+	for (; *s; ++s) {
+		if (*s == '"' || *s == '\\') {
+			fputc('\\', f);
+		}
+		fputc(*s, f);
+	}
+	fputc('"', f);
+}
+
+bool runBatch(const char* jobs_path, const char* out_path, int n_threads, int pool_size, const SolveParams& params) {
+	std::vector<BatchJob> jobs;
+	if (!readBatchJobs(jobs_path, jobs)) {
+		printf("Failed to read batch jobs from %s\n", jobs_path);
+		return false;
+	}
+	FILE* out = out_path ? fopen(out_path, "w") : stdout;
+	if (!out) {
+		printf("Failed to open %s\n", out_path);
+		return false;
+	}
+
+	std::mutex out_mutex;
+	std::vector<std::unique_ptr<Solver>> solvers(std::max(1, n_threads));
+	{
+		// Solvers are created on the workers so each pool is first touched by its own thread
+		WorkStealingPool pool((int)solvers.size(), [&solvers, pool_size](int worker) { solvers[worker] = std::make_unique<Solver>(pool_size); });
+		for (size_t i = 0; i < jobs.size(); ++i) {
+			const BatchJob* job = &jobs[i];
+			pool.submit([job, i, out, &out_mutex, &params, &solvers](int worker) {
+				timerBegin();
+				SolveResult r = solvers[worker]->solve(job->ctx, params);
+				float elapsed = timerEnd();
+
+				std::lock_guard<std::mutex> lock(out_mutex);
+				fprintf(out, "{\"job\":%i,\"line\":%i,\"name\":", (int)i, job->line);
+				writeJsonString(out, job->name.c_str());
+				fprintf(out, ",\"found\":%s,\"from_cache\":%s,\"book_moves\":%i,\"improved\":%s,\"progress\":%i,\"quality\":%i,\"durability\":%i,\"cp\":%i,\"steps\":%i,\"macro\":[",
+					r.found ? "true" : "false", r.from_cache ? "true" : "false", r.book_moves, r.improved ? "true" : "false", r.progress, r.quality, r.durability, r.cp, (int)r.actions.size()
+				);
+				for (size_t a = 0; a < r.actions.size(); ++a) {
+					fprintf(out, "%s\"%s\"", a ? "," : "", actionToString(r.actions[a]));
+				}
+				fprintf(out, "],\"playouts\":%i,\"elapsed_sec\":%.3f,\"worker\":%i}\n", r.playouts, elapsed, worker);
+				fflush(out);
+			});
+		}
+		pool.wait();
+	}
+
+	if (out != stdout) {
+		fclose(out);
+	}
+	return true;
+}
+
+bool compareEngines(const char* jobs_path, int n_threads, int pool_size, const std::vector<float>& budgets_sec, const SolveParams& params) {
+	std::vector<BatchJob> jobs;
+	if (!readBatchJobs(jobs_path, jobs)) {
+		printf("Failed to read batch jobs from %s\n", jobs_path);
+		return false;
+	}
+	struct EngineRun {
+		const char* name;
+		SOLVE_ENGINE engine;
+		bool timed;
+	};
+	const EngineRun runs[] = {
+		{ "phases", ENGINE_PHASES, false },
+		{ "mcts", ENGINE_MCTS, true },
+		{ "nrpa", ENGINE_NRPA, true },
+		{ "ga", ENGINE_GA, true },
+		{ "lds", ENGINE_LDS, true }
+	};
+	Solver solver(pool_size);
+	printf("%-24s %-8s %8s %8s %10s %8s\n", "job", "engine", "budget", "found", "quality", "sec");
+	for (const BatchJob& job : jobs) {
+		const char* name = job.name.empty() ? "-" : job.name.c_str();
+		for (const EngineRun& run : runs) {
+			for (size_t b = 0; b < (run.timed ? budgets_sec.size() : 1); ++b) {
+				SolveParams p = params;
+				p.engine = run.engine;
+				p.cache_dir = 0;
+				p.improve_ms = 0;
+				p.n_iterations = 1'000'000'000;
+				p.nrpa_level = 5;
+				p.ga_generations = 1'000'000'000;
+				p.lds_discrepancies = p.max_steps;
+				p.engine_threads = std::max(1, n_threads);
+				if (run.timed) {
+					p.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds((int)(budgets_sec[b] * 1000));
+				}
+				timerBegin();
+				SolveResult r = solver.solve(job.ctx, p);
+				float elapsed = timerEnd();
+				printf("%-24s %-8s %8.1f %8s %10i %8.2f\n", name, run.name, run.timed ? budgets_sec[b] : .0f,
+					r.found ? "yes" : "no", r.quality, elapsed
+				);
+				fflush(stdout);
+			}
+		}
+		// All of them at once, sharing the threads and an incumbent
+		const std::vector<SOLVE_ENGINE> all = { ENGINE_PHASES, ENGINE_MCTS, ENGINE_NRPA, ENGINE_GA, ENGINE_LDS };
+		for (float budget : budgets_sec) {
+			SolveParams p = params;
+			p.cache_dir = 0;
+			p.improve_ms = 0;
+			p.n_iterations = 1'000'000'000;
+			p.nrpa_level = 5;
+			p.ga_generations = 1'000'000'000;
+			p.lds_discrepancies = p.max_steps;
+			p.engine_threads = std::max(1, n_threads / (int)all.size());
+			p.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds((int)(budget * 1000));
+			timerBegin();
+			PortfolioResult r = solvePortfolio(job.ctx, p, all, pool_size);
+			float elapsed = timerEnd();
+			printf("%-24s %-8s %8.1f %8s %10i %8.2f  %s\n", name, "all", budget, r.best.found ? "yes" : "no", r.best.quality, elapsed,
+				r.winner < 0 ? "" : engineName(all[r.winner])
+			);
+			fflush(stdout);
+		}
+	}
+	return true;
+}
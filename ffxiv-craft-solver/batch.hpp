@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "solver.hpp"
+
+
+struct BatchJob {
+	int line;
+	std::string name;
+	GameContext ctx;
+};
+
+// A job is one line, the recipe columns of recipes.txt without the id, then the crafter's CP:
+//	# base_progress  base_quality  target_progress  target_quality  durability  cp  [name]
+//	259	256	7500	16500	70	598	Grade 2 Gemdraught of Intelligence
+// Blank lines and lines starting with '#' are skipped. Malformed lines are reported and fail the read
+bool readBatchJobs(const char* path, std::vector<BatchJob>& jobs);
+
+// Solves every job in 'jobs_path' on a work-stealing pool of n_threads workers,
+// each with its own game state pool of 'pool_size' states.
+// Results are streamed as JSON lines to 'out_path' (stdout if null) as jobs finish
+bool runBatch(const char* jobs_path, const char* out_path, int n_threads, int pool_size, const SolveParams& params);
+
+// Solves every job with MCTS, NRPA, the GA and LDS under each wall-clock budget in turn and prints a table of
+// the quality reached, with the phase planner as a reference. Search budgets in 'params' are lifted
+// so the deadline is what stops an engine. A last row per budget runs them all as a portfolio, see
+// portfolio.hpp. Neither the solution cache nor the post-pass is used
+bool compareEngines(const char* jobs_path, int n_threads, int pool_size, const std::vector<float>& budgets_sec, const SolveParams& params);
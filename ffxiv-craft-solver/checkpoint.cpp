@@ -0,0 +1,126 @@
+#include "checkpoint.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <filesystem>
+#include "game_state_handle.hpp"
+#include "mapped_file.hpp"
+
+
+constexpr uint32_t CHECKPOINT_MAGIC = 0x50435846; // "FXCP"
+constexpr uint32_t CHECKPOINT_VERSION = 4;
+
+struct CheckpointHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t ctx_size;
+	uint32_t rng_state_size;
+
+	int32_t n_iterations;
+	int32_t max_steps;
+	float exploration_constant;
+	float max_score_weight;
+
+	int32_t iteration;
+	int32_t n_useless_selections;
+	int32_t total_playouts;
+	int32_t n_deleted_states;
+	double best_score;
+
+	int32_t root_idx;
+	int32_t last_deadend_idx;
+	uint64_t combo_set_hash;
+};
+
+bool saveCheckpoint(const char* path, const SearchCheckpoint& cp) {
+	std::string tmp_path = std::string(path) + ".tmp";
+	FILE* f = fopen(tmp_path.c_str(), "wb");
+	if (!f) {
+		return false;
+	}
+
+	CheckpointHeader header = {
+		.magic = CHECKPOINT_MAGIC,
+		.version = CHECKPOINT_VERSION,
+		.ctx_size = sizeof(GameContext),
+		.rng_state_size = (uint32_t)cp.rng_state.size(),
+		.n_iterations = cp.n_iterations,
+		.max_steps = cp.max_steps,
+		.exploration_constant = cp.exploration_constant,
+		.max_score_weight = cp.max_score_weight,
+		.iteration = cp.iteration,
+		.n_useless_selections = cp.n_useless_selections,
+		.total_playouts = cp.total_playouts,
+		.n_deleted_states = cp.n_deleted_states,
+		.best_score = cp.best_score,
+		.root_idx = cp.root_idx,
+		.last_deadend_idx = cp.last_deadend_idx,
+		.combo_set_hash = cp.combo_set_hash
+	};
+
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1
+		&& fwrite(&cp.ctx, sizeof(cp.ctx), 1, f) == 1
+		&& fwrite(cp.rng_state.data(), 1, cp.rng_state.size(), f) == cp.rng_state.size()
+		&& writeGameStatePool(f);
+	ok = (fclose(f) == 0) && ok;
+	if (!ok) {
+		remove(tmp_path.c_str());
+		return false;
+	}
+
+	std::error_code ec;
+	std::filesystem::rename(tmp_path, path, ec);
+	return !ec;
+}
+
+bool loadCheckpoint(const char* path, SearchCheckpoint& cp) {
+	MappedFile file;
+	if (!mapFileRead(path, file)) {
+		return false;
+	}
+	const uint8_t* cursor = (const uint8_t*)file.data;
+	const uint8_t* end = cursor + file.size;
+
+	CheckpointHeader header;
+	if (file.size < sizeof(header)) {
+		unmapFile(file);
+		return false;
+	}
+	memcpy(&header, cursor, sizeof(header));
+	cursor += sizeof(header);
+	if (header.magic != CHECKPOINT_MAGIC
+		|| header.version != CHECKPOINT_VERSION
+		|| header.ctx_size != sizeof(GameContext)
+		|| end - cursor < (ptrdiff_t)(header.ctx_size + header.rng_state_size)
+	) {
+		unmapFile(file);
+		return false;
+	}
+
+	memcpy(&cp.ctx, cursor, sizeof(cp.ctx));
+	cursor += sizeof(cp.ctx);
+	cp.rng_state.assign((const char*)cursor, header.rng_state_size);
+	cursor += header.rng_state_size;
+
+	cp.n_iterations = header.n_iterations;
+	cp.max_steps = header.max_steps;
+	cp.exploration_constant = header.exploration_constant;
+	cp.max_score_weight = header.max_score_weight;
+	cp.iteration = header.iteration;
+	cp.n_useless_selections = header.n_useless_selections;
+	cp.total_playouts = header.total_playouts;
+	cp.n_deleted_states = header.n_deleted_states;
+	cp.best_score = header.best_score;
+	cp.root_idx = header.root_idx;
+	cp.last_deadend_idx = header.last_deadend_idx;
+	cp.combo_set_hash = header.combo_set_hash;
+
+	bool ok = readGameStatePool(cursor, end);
+	unmapFile(file);
+	const int n_states = getGameStatePoolHighWater();
+	return ok
+		&& cp.root_idx >= 0 && cp.root_idx < n_states
+		&& cp.last_deadend_idx >= -1 && cp.last_deadend_idx < n_states;
+}
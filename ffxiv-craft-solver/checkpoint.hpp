@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include "game_config.hpp"
+
+
+// Everything monteCarloSearch2 needs to continue where it left off.
+// The node pool itself is written/restored alongside this
+struct SearchCheckpoint {
+	GameContext ctx;
+
+	int n_iterations;
+	int max_steps;
+	float exploration_constant;
+	float max_score_weight;
+
+	int iteration;
+	int n_useless_selections;
+	int total_playouts;
+	int n_deleted_states;
+	double best_score;
+
+	int root_idx;
+	int last_deadend_idx;
+	// Node combo bits index this set, see comboSetHash()
+	uint64_t combo_set_hash;
+
+	std::string rng_state;
+};
+
+// Writes to a temporary file first and renames it over the old checkpoint,
+// so a crash mid-write never leaves a truncated file behind
+bool saveCheckpoint(const char* path, const SearchCheckpoint& cp);
+// The game state pool must already be initialized with enough capacity
+bool loadCheckpoint(const char* path, SearchCheckpoint& cp);
@@ -0,0 +1,157 @@
+#include "combo_set.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <set>
+
+
+static int rankOf(const LearnedCombo& c) {
+	return c.support * ((int)c.actions.size() - 1);
+}
+
+void mineCombos(const SolutionIndex& index, int max_count, int min_support, ComboSet& out) {
+	out.combos.clear();
+	std::map<std::vector<ACTION>, int> support;
+	for (const SolutionIndexEntry& e : index.entries) {
+		if (e.sol.progress < e.ctx.target_progress) {
+			continue;
+		}
+		const std::vector<ACTION>& macro = e.sol.actions;
+		std::set<std::vector<ACTION>> seen;
+		for (int len = COMBO_MIN_LEN; len <= COMBO_MAX_LEN; ++len) {
+			for (int i = 0; i + len <= (int)macro.size(); ++i) {
+				seen.emplace(macro.begin() + i, macro.begin() + i + len);
+			}
+		}
+		for (const std::vector<ACTION>& run : seen) {
+			++support[run];
+		}
+	}
+
+	std::vector<LearnedCombo> ranked;
+	for (auto& [run, n] : support) {
+		if (n >= min_support) {
+			ranked.push_back(LearnedCombo{ .actions = run, .support = n });
+		}
+	}
+	std::stable_sort(ranked.begin(), ranked.end(), [](const LearnedCombo& a, const LearnedCombo& b)->bool {
+		return rankOf(a) > rankOf(b);
+	});
+	max_count = std::min(max_count, COMBO_SET_MAX);
+	for (const LearnedCombo& c : ranked) {
+		if ((int)out.combos.size() >= max_count) {
+			break;
+		}
+		bool subsumed = std::any_of(out.combos.begin(), out.combos.end(), [&c](const LearnedCombo& kept) {
+			return kept.support >= c.support
+				&& std::search(kept.actions.begin(), kept.actions.end(), c.actions.begin(), c.actions.end()) != kept.actions.end();
+		});
+		if (!subsumed) {
+			out.combos.push_back(c);
+		}
+	}
+}
+
+uint64_t comboSetHash(const ComboSet* set) {
+	if (!set || set->combos.empty()) {
+		return 0;
+	}
+	// FNV-1a over each combo's length and actions
+	uint64_t h = 14695981039346656037ull;
+	auto mix = [&h](uint64_t v) {
+		h = (h ^ v) * 1099511628211ull;
+	};
+	for (const LearnedCombo& c : set->combos) {
+		mix(c.actions.size());
+		for (ACTION a : c.actions) {
+			mix((uint64_t)a);
+		}
+	}
+	return h;
+}
+
+bool readComboSet(const char* path, ComboSet& out) {
+	FILE* f = fopen(path, "r");
+	if (!f) {
+		return false;
+	}
+	out.combos.clear();
+	char buf[512];
+	int line = 0;
+	bool ok = true;
+	while (fgets(buf, sizeof(buf), f)) {
+		++line;
+		const char* s = buf + strspn(buf, " \t");
+		if (*s == '#' || *s == '\r' || *s == '\n' || *s == '\0') {
+			continue;
+		}
+		LearnedCombo combo;
+		int n = 0;
+		if (sscanf(s, "%i%n", &combo.support, &n) != 1) {
+			printf("%s:%i: expected the support first\n", path, line);
+			ok = false;
+			continue;
+		}
+		s += n;
+		char name[32];
+		bool line_ok = true;
+		while (sscanf(s, "%31s%n", name, &n) == 1) {
+			s += n;
+			ACTION a;
+			if (!actionFromString(name, a)) {
+				printf("%s:%i: unknown action %s\n", path, line, name);
+				line_ok = false;
+				break;
+			}
+			combo.actions.push_back(a);
+		}
+		if (line_ok && ((int)combo.actions.size() < COMBO_MIN_LEN || (int)combo.actions.size() > COMBO_MAX_LEN)) {
+			printf("%s:%i: a combo takes %i to %i actions\n", path, line, COMBO_MIN_LEN, COMBO_MAX_LEN);
+			line_ok = false;
+		}
+		if (!line_ok) {
+			ok = false;
+			continue;
+		}
+		if ((int)out.combos.size() == COMBO_SET_MAX) {
+			printf("%s:%i: only the first %i combos are used\n", path, line, COMBO_SET_MAX);
+			break;
+		}
+		out.combos.push_back(combo);
+	}
+	fclose(f);
+	return ok;
+}
+
+bool writeComboSet(const char* path, const ComboSet& set) {
+	FILE* f = fopen(path, "w");
+	if (!f) {
+		return false;
+	}
+	fprintf(f, "# support, then the actions\n");
+	for (const LearnedCombo& c : set.combos) {
+		fprintf(f, "%i", c.support);
+		for (ACTION a : c.actions) {
+			fprintf(f, " %s", actionToString(a));
+		}
+		fprintf(f, "\n");
+	}
+	return fclose(f) == 0;
+}
+
+bool buildComboSet(const char* cache_dir, const char* path, int max_count) {
+	SolutionIndex index;
+	if (!loadSolutionIndex(cache_dir, index)) {
+		return false;
+	}
+	ComboSet set;
+	// Anything rarer is more likely one craft's quirk than a pattern
+	mineCombos(index, max_count, 2, set);
+	if (!writeComboSet(path, set)) {
+		return false;
+	}
+	printf("Combo set: %i combos from %i cached macros\n", (int)set.combos.size(), (int)index.entries.size());
+	return true;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "action_enum.hpp"
+#include "solution_cache.hpp"
+
+
+// Learned combos: short action runs that keep showing up in the best macros, mined from a
+// solution cache directory instead of written by hand like combos[] in actions.hpp.
+// MCTS can expand one as a single edge next to the primitive actions, which skips the
+// intermediate decisions and makes long crafts effectively shallower.
+// Stored as text, one combo per line: its support, then its action names
+//	14 MANIPULATION VENERATION GROUNDWORK
+
+constexpr int COMBO_MIN_LEN = 2;
+constexpr int COMBO_MAX_LEN = 4;
+constexpr int COMBO_SET_MAX = 32;	// Tried per node as a bit mask, see GameState::combos_expanded
+
+struct LearnedCombo {
+	std::vector<ACTION> actions;
+	int support = 0;	// Finished macros containing it at least once
+};
+
+struct ComboSet {
+	std::vector<LearnedCombo> combos;	// Most useful first
+};
+
+// Counts every run of COMBO_MIN_LEN to COMBO_MAX_LEN actions once per finished macro in 'index'
+// and keeps up to 'max_count' seen in at least 'min_support' of them, ranked by support times
+// the steps they save. A run adding nothing over a longer kept one with the same support is left out
+void mineCombos(const SolutionIndex& index, int max_count, int min_support, ComboSet& out);
+
+// Identifies the combos and their order, which is what node bits index. 0 without a set
+uint64_t comboSetHash(const ComboSet* set);
+
+bool readComboSet(const char* path, ComboSet& out);
+bool writeComboSet(const char* path, const ComboSet& set);
+
+// Mines the solutions cached in 'cache_dir' into a combo file at 'path'
+bool buildComboSet(const char* cache_dir, const char* path, int max_count);
@@ -1,5 +1,5 @@
-#pragma once
-
-
-
-//constexpr int MAX_STEP = 5;
+#pragma once
+
+
+
+//constexpr int MAX_STEP = 5;
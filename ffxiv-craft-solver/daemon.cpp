@@ -0,0 +1,543 @@
+#include "daemon.hpp"
+
+#include <ctype.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+#include <afunix.h>
+typedef SOCKET socket_t;
+#define closeSocket closesocket
+#define pollSockets WSAPoll
+#define MSG_NOSIGNAL 0
+#else
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+typedef int socket_t;
+#define INVALID_SOCKET -1
+#define closeSocket close
+#define pollSockets poll
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+#include "action_enum.hpp"
+#include "recipe_db.hpp"
+#include "solver.hpp"
+#include "work_stealing_pool.hpp"
+
+
+// Just enough JSON for flat request objects: strings, numbers, literals and arrays of strings
+struct JsonField {
+	std::string raw;	// Value as it appeared in the request, for echoing back
+	std::string str;
+	double number = 0;
+	bool is_string = false;
+	bool is_number = false;
+	std::vector<std::string> items;
+};
+
+static void skipSpace(const char*& p) {
+	while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+		++p;
+	}
+}
+
+static bool parseJsonString(const char*& p, std::string& out) {
+	if (*p != '"') {
+		return false;
+	}
+	++p;
+	out.clear();
+	while (*p && *p != '"') {
+		char c = *p++;
+		if (c == '\\') {
+			c = *p++;
+			switch (c) {
+			case 'n': c = '\n'; break;
+			case 't': c = '\t'; break;
+			case 'r': c = '\r'; break;
+			case 'b': c = '\b'; break;
+			case 'f': c = '\f'; break;
+			case 'u': {
+				// Names and ids are ASCII, anything else is replaced
+				unsigned code = 0;
+				for (int i = 0; i < 4; ++i, ++p) {
+					if (!isxdigit((unsigned char)*p)) {
+						return false;
+					}
+					code = code * 16 + (isdigit((unsigned char)*p) ? *p - '0' : (tolower(*p) - 'a' + 10));
+				}
+				c = code < 0x80 ? (char)code : '?';
+				break;
+			}
+			case '\0': return false;
+			}
+		}
+		out += c;
+	}
+	if (*p != '"') {
+		return false;
+	}
+	++p;
+	return true;
+}
+
+static bool parseJsonObject(const char* p, std::map<std::string, JsonField>& fields) {
+	skipSpace(p);
+	if (*p++ != '{') {
+		return false;
+	}
+	skipSpace(p);
+	if (*p == '}') {
+		return true;
+	}
+	for (;;) {
+		std::string key;
+		skipSpace(p);
+		if (!parseJsonString(p, key)) {
+			return false;
+		}
+		skipSpace(p);
+		if (*p++ != ':') {
+			return false;
+		}
+		skipSpace(p);
+
+		JsonField field;
+		const char* value_begin = p;
+		if (*p == '"') {
+			if (!parseJsonString(p, field.str)) {
+				return false;
+			}
+			field.is_string = true;
+		} else if (*p == '[') {
+			++p;
+			skipSpace(p);
+			while (*p != ']') {
+				std::string item;
+				if (!parseJsonString(p, item)) {
+					return false;
+				}
+				field.items.push_back(item);
+				skipSpace(p);
+				if (*p == ',') {
+					++p;
+					skipSpace(p);
+				} else if (*p != ']') {
+					return false;
+				}
+			}
+			++p;
+		} else if (!strncmp(p, "true", 4) || !strncmp(p, "null", 4)) {
+			p += 4;
+		} else if (!strncmp(p, "false", 5)) {
+			p += 5;
+		} else {
+			char* num_end = 0;
+			field.number = strtod(p, &num_end);
+			if (num_end == p) {
+				return false;
+			}
+			field.is_number = true;
+			p = num_end;
+		}
+		field.raw.assign(value_begin, p);
+		fields[key] = field;
+
+		skipSpace(p);
+		if (*p == ',') {
+			++p;
+			continue;
+		}
+		return *p == '}';
+	}
+}
+
+static void appendJsonString(std::string& out, const char* s) {
+	out += '"';
+	for (; *s; ++s) {
+		switch (*s) {
+		case '"': out += "\\\""; break;
+		case '\\': out += "\\\\"; break;
+		case '\n': out += "\\n"; break;
+		default: out += *s;
+		}
+	}
+	out += '"';
+}
+
+
+struct Connection {
+	socket_t sock;
+	std::mutex write_mutex;
+	// Set once replies can't be delivered, queued requests are dropped and running ones stopped.
+	// A client that only shuts down its sending side still gets its answers
+	std::atomic<bool> closed = false;
+
+	~Connection() {
+		closeSocket(sock);
+	}
+
+	void send(const std::string& line) {
+		std::lock_guard<std::mutex> lock(write_mutex);
+		size_t at = 0;
+		while (at < line.size() && !closed) {
+			int n = ::send(sock, line.data() + at, (int)(line.size() - at), MSG_NOSIGNAL);
+			if (n <= 0) {
+				closed = true;
+				return;
+			}
+			at += n;
+		}
+	}
+};
+
+struct DaemonRequest {
+	std::string id;
+	int priority;
+	int64_t arrival;
+	std::shared_ptr<Connection> conn;
+	GameContext ctx;
+	SolveParams params;
+};
+
+// Highest priority first, then earliest deadline, then arrival order
+struct RequestOrder {
+	bool operator()(const DaemonRequest* a, const DaemonRequest* b) const {
+		if (a->priority != b->priority) {
+			return a->priority < b->priority;
+		}
+		auto da = a->params.deadline == std::chrono::steady_clock::time_point() ? std::chrono::steady_clock::time_point::max() : a->params.deadline;
+		auto db = b->params.deadline == std::chrono::steady_clock::time_point() ? std::chrono::steady_clock::time_point::max() : b->params.deadline;
+		if (da != db) {
+			return da > db;
+		}
+		return a->arrival > b->arrival;
+	}
+};
+
+static std::mutex queue_mutex;
+static std::priority_queue<DaemonRequest*, std::vector<DaemonRequest*>, RequestOrder> request_queue;
+static int64_t n_received = 0;
+static RecipeDb recipe_db;
+static bool has_recipe_db = false;
+static std::atomic<int> n_readers = 0;
+static SolveParams default_params;
+// One per worker, indexed by the pool's worker id
+static std::vector<std::unique_ptr<Solver>> solvers;
+
+static void sendError(Connection& conn, const std::string& id, const char* error) {
+	std::string line = "{\"id\":" + id + ",\"error\":";
+	appendJsonString(line, error);
+	line += "}\n";
+	conn.send(line);
+}
+
+static void sendResult(Connection& conn, const std::string& id, const SolveResult& r) {
+	char buf[256];
+	snprintf(buf, sizeof(buf), ",\"found\":%s,\"from_cache\":%s,\"book_moves\":%i,\"improved\":%s,\"progress\":%i,\"quality\":%i,\"durability\":%i,\"cp\":%i,\"steps\":%i,\"playouts\":%i,\"macro\":[",
+		r.found ? "true" : "false", r.from_cache ? "true" : "false", r.book_moves, r.improved ? "true" : "false", r.progress, r.quality, r.durability, r.cp, (int)r.actions.size(), r.playouts
+	);
+	std::string line = "{\"id\":" + id + buf;
+	for (size_t i = 0; i < r.actions.size(); ++i) {
+		if (i) {
+			line += ',';
+		}
+		appendJsonString(line, actionToString(r.actions[i]));
+	}
+	line += "],\"macro_text\":";
+	appendJsonString(line, formatMacro(r.actions.data(), (int)r.actions.size()).c_str());
+	line += "}\n";
+	conn.send(line);
+}
+
+// Picks whatever is most urgent now rather than the request the task was submitted for
+static void runNextRequest(Solver& solver) {
+	DaemonRequest* req = 0;
+	{
+		std::lock_guard<std::mutex> lock(queue_mutex);
+		req = request_queue.top();
+		request_queue.pop();
+	}
+	std::unique_ptr<DaemonRequest> owner(req);
+	if (req->conn->closed || break_requested) {
+		return;
+	}
+	if (req->params.deadline != std::chrono::steady_clock::time_point()
+		&& std::chrono::steady_clock::now() >= req->params.deadline) {
+		sendError(*req->conn, req->id, "deadline expired before the request was scheduled");
+		return;
+	}
+	req->params.cancel = &req->conn->closed;
+	SolveResult r = solver.solve(req->ctx, req->params);
+	if (!r.prefix_ok) {
+		sendError(*req->conn, req->id, "prefix cannot be executed");
+		return;
+	}
+	sendResult(*req->conn, req->id, r);
+}
+
+static bool parseRequest(const char* line, DaemonRequest& req, const char*& error) {
+	std::map<std::string, JsonField> fields;
+	if (!parseJsonObject(line, fields)) {
+		error = "malformed JSON";
+		return false;
+	}
+	auto field = [&](const char* name) -> const JsonField* {
+		auto it = fields.find(name);
+		return it == fields.end() ? 0 : &it->second;
+	};
+	// Absent fields keep 'out' as it is, values an int can't hold fail the request
+	auto number = [&](const char* name, int& out) -> bool {
+		const JsonField* f = field(name);
+		if (!f || !f->is_number) {
+			return true;
+		}
+		if (!(f->number >= INT_MIN && f->number <= INT_MAX)) {
+			error = "number out of range";
+			return false;
+		}
+		out = (int)f->number;
+		return true;
+	};
+
+	if (const JsonField* f = field("id")) {
+		req.id = f->raw;
+	}
+
+	req.params = default_params;
+	req.ctx = GameContext{};
+	if (const JsonField* f = field("recipe")) {
+		if (!has_recipe_db) {
+			error = "no recipe database loaded";
+			return false;
+		}
+		if (f->is_number && !(f->number >= 0 && f->number <= UINT32_MAX)) {
+			error = "recipe not found";
+			return false;
+		}
+		const RecipeRecord* recipe = f->is_number ? findRecipe(recipe_db, (uint32_t)f->number) : findRecipeByName(recipe_db, f->str.c_str());
+		if (!recipe) {
+			error = "recipe not found";
+			return false;
+		}
+		req.ctx = makeGameContext(*recipe, 0);
+	}
+	if (!number("cp", req.ctx.max_cp)
+		|| !number("base_progress", req.ctx.base_progress_increase)
+		|| !number("base_quality", req.ctx.base_quality_increase)
+		|| !number("target_progress", req.ctx.target_progress)
+		|| !number("target_quality", req.ctx.target_quality)
+		|| !number("max_durability", req.ctx.max_durability)) {
+		return false;
+	}
+	if (req.ctx.max_cp <= 0 || req.ctx.base_progress_increase <= 0 || req.ctx.base_quality_increase <= 0
+		|| req.ctx.target_progress <= 0 || req.ctx.max_durability <= 0) {
+		error = "missing craft stats";
+		return false;
+	}
+
+	req.priority = 0;
+	int deadline_ms = 0;
+	if (!number("priority", req.priority)
+		|| !number("iterations", req.params.n_iterations)
+		|| !number("deadline_ms", deadline_ms)) {
+		return false;
+	}
+	if (deadline_ms > 0) {
+		req.params.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(deadline_ms);
+	}
+	if (const JsonField* f = field("prefix")) {
+		for (const std::string& name : f->items) {
+			ACTION a;
+			if (!actionFromString(name.c_str(), a)) {
+				error = "unknown action in prefix";
+				return false;
+			}
+			req.params.prefix.push_back(a);
+		}
+	}
+	if (const JsonField* f = field("engine")) {
+		if (!engineFromString(f->str.c_str(), req.params.engine)) {
+			error = "unknown engine";
+			return false;
+		}
+	}
+	if (const JsonField* f = field("seed")) {
+		std::vector<ACTION> seed;
+		for (const std::string& name : f->items) {
+			ACTION a;
+			if (!actionFromString(name.c_str(), a)) {
+				error = "unknown action in seed";
+				return false;
+			}
+			seed.push_back(a);
+		}
+		req.params.seeds.push_back(seed);
+	}
+	return true;
+}
+
+// Longest request line accepted, a client that never sends a newline is cut off here
+constexpr size_t MAX_REQUEST_LINE = 64 * 1024;
+
+static void connectionLoop(std::shared_ptr<Connection> conn, WorkStealingPool* pool) {
+	std::string pending;
+	char buf[4096];
+	for (;;) {
+		int n = recv(conn->sock, buf, sizeof(buf), 0);
+		// End of input only ends reading, requests already queued are still answered
+		if (n == 0) {
+			break;
+		}
+		if (n < 0) {
+			conn->closed = true;
+			break;
+		}
+		pending.append(buf, n);
+		size_t eol;
+		while ((eol = pending.find('\n')) != std::string::npos) {
+			std::string line = pending.substr(0, eol);
+			pending.erase(0, eol + 1);
+			if (line.find_first_not_of(" \t\r") == std::string::npos) {
+				continue;
+			}
+
+			auto req = std::make_unique<DaemonRequest>();
+			req->id = "null";
+			req->conn = conn;
+			const char* error = 0;
+			if (!parseRequest(line.c_str(), *req, error)) {
+				sendError(*conn, req->id, error);
+				continue;
+			}
+			{
+				std::lock_guard<std::mutex> lock(queue_mutex);
+				req->arrival = n_received++;
+				request_queue.push(req.release());
+			}
+			pool->submit([](int worker) { runNextRequest(*solvers[worker]); });
+		}
+		if (pending.size() > MAX_REQUEST_LINE) {
+			sendError(*conn, "null", "request line too long");
+			conn->closed = true;
+			shutdown(conn->sock, 2);
+			break;
+		}
+	}
+	--n_readers;
+}
+
+bool runDaemon(const char* socket_path, const char* recipe_db_path, int n_threads, int pool_size, const SolveParams& defaults) {
+	default_params = defaults;
+#ifdef _WIN32
+	WSADATA wsa;
+	if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+		return false;
+	}
+#else
+	// A client hanging up mid-reply must not take the daemon down
+	signal(SIGPIPE, SIG_IGN);
+#endif
+	if (recipe_db_path) {
+		if (!openRecipeDb(recipe_db_path, recipe_db)) {
+			printf("Failed to open recipe database %s\n", recipe_db_path);
+			return false;
+		}
+		has_recipe_db = true;
+	}
+
+	sockaddr_un addr = {};
+	addr.sun_family = AF_UNIX;
+	if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+		printf("Socket path too long: %s\n", socket_path);
+		return false;
+	}
+	strcpy(addr.sun_path, socket_path);
+	remove(socket_path);
+
+	socket_t listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener == INVALID_SOCKET
+		|| bind(listener, (sockaddr*)&addr, sizeof(addr)) != 0
+		|| listen(listener, 16) != 0) {
+		printf("Failed to listen on %s\n", socket_path);
+		if (listener != INVALID_SOCKET) {
+			closeSocket(listener);
+		}
+		return false;
+	}
+
+	solvers.resize(std::max(1, n_threads));
+	{
+		// Solvers are created on the workers so each pool is first touched by its own thread
+		WorkStealingPool pool((int)solvers.size(), [pool_size](int worker) { solvers[worker] = std::make_unique<Solver>(pool_size); });
+		printf("Listening on %s with %i workers\n", socket_path, pool.threadCount());
+		fflush(stdout);
+
+		std::vector<std::weak_ptr<Connection>> connections;
+		while (!break_requested) {
+			pollfd pfd = {};
+			pfd.fd = listener;
+			pfd.events = POLLIN;
+			// Wakes up now and then to notice Ctrl-C
+			if (pollSockets(&pfd, 1, 200) <= 0) {
+				continue;
+			}
+			socket_t client = accept(listener, 0, 0);
+			if (client == INVALID_SOCKET) {
+				continue;
+			}
+			auto conn = std::make_shared<Connection>();
+			conn->sock = client;
+			std::erase_if(connections, [](const std::weak_ptr<Connection>& c) { return c.expired(); });
+			connections.push_back(conn);
+			++n_readers;
+			std::thread(connectionLoop, conn, &pool).detach();
+		}
+
+		printf("Shutting down\n");
+		for (auto& weak : connections) {
+			if (auto conn = weak.lock()) {
+				conn->closed = true;
+				shutdown(conn->sock, 2);
+			}
+		}
+		while (n_readers > 0) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		pool.wait();
+	}
+	solvers.clear();
+
+	closeSocket(listener);
+	remove(socket_path);
+	if (has_recipe_db) {
+		closeRecipeDb(recipe_db);
+	}
+#ifdef _WIN32
+	WSACleanup();
+#endif
+	return true;
+}
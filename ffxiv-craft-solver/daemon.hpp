@@ -0,0 +1,24 @@
+#pragma once
+
+#include "solver.hpp"
+
+// Serves solve requests on a Unix domain socket until Ctrl-C.
+// Workers keep their game state pools and the weight table between requests,
+// so a request pays only for the search itself.
+//
+// Both directions are one JSON object per line. Request fields:
+//   id                 echoed back as-is
+//   recipe             id or name, looked up in the recipe database
+//   cp, base_progress, base_quality, target_progress, target_quality, max_durability
+//                      override (or without a recipe, give) the craft stats
+//   priority           higher runs first, default 0
+//   deadline_ms        counted from arrival, the best craft found by then is returned
+//   iterations         search budget, defaults to the solver's
+//   prefix             array of action names forced at the start
+//   seed               array of action names of a known macro to start the search from
+//   engine             "mcts" (default), "phases", "nrpa", "ga" or "lds"
+// Anything not given comes from 'defaults'
+// Replies come back in completion order, matched by id. Clients keep the connection
+// open until their replies arrive: once it closes, queued requests are dropped and
+// running searches stopped
+bool runDaemon(const char* socket_path, const char* recipe_db_path, int n_threads, int pool_size, const SolveParams& defaults);
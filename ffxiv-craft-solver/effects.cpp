@@ -1,33 +1,33 @@
-#include "effects.hpp"
-#include "game_state.hpp"
-
-Effect effects[] = {
-	{
-		.name = "Inner Quiet",
-		.is_stackable = true
-	},
-	{
-		.name = "Waste Not" // Use this for Waste Not II too
-	},
-	{
-		.name = "Veneration"
-	},
-	{
-		.name = "Great Strides"
-	},
-	{
-		.name = "Innovation"
-	},
-	{
-		.name = "Final Appraisal"
-	},
-	{
-		.name = "Muscle Memory"
-	},
-	{
-		.name = "Manipulation"
-	},
-	{
-		.name = "Trained Perfection"
-	}
+#include "effects.hpp"
+#include "game_state.hpp"
+
+Effect effects[] = {
+	{
+		.name = "Inner Quiet",
+		.is_stackable = true
+	},
+	{
+		.name = "Waste Not" // Use this for Waste Not II too
+	},
+	{
+		.name = "Veneration"
+	},
+	{
+		.name = "Great Strides"
+	},
+	{
+		.name = "Innovation"
+	},
+	{
+		.name = "Final Appraisal"
+	},
+	{
+		.name = "Muscle Memory"
+	},
+	{
+		.name = "Manipulation"
+	},
+	{
+		.name = "Trained Perfection"
+	}
 };
\ No newline at end of file
@@ -0,0 +1,244 @@
+#include "endgame_table.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "actions.hpp"
+#include "solution_cache.hpp"
+#include "solver.hpp"
+
+
+constexpr uint32_t ENDGAME_TABLE_MAGIC = 0x54474546; // "FEGT"
+constexpr uint32_t ENDGAME_TABLE_VERSION = 1;
+
+constexpr int CP_BUCKETS = ENDGAME_MAX_CP / ENDGAME_CP_STEP + 1;
+constexpr int DURABILITY_BUCKETS = ENDGAME_MAX_DURABILITY / 5 + 1;
+constexpr int IQ_STACKS = 11;
+constexpr int INNOVATION_CHARGES = 5;
+constexpr int GREAT_STRIDES_CHARGES = 4;
+constexpr int PROGRESS_BUCKETS = ENDGAME_MAX_PROGRESS_TENTHS + 1;
+constexpr int COMBO_KINDS = 3;
+constexpr int ENDGAME_ENTRY_COUNT = CP_BUCKETS * DURABILITY_BUCKETS * IQ_STACKS * INNOVATION_CHARGES
+	* GREAT_STRIDES_CHARGES * PROGRESS_BUCKETS * COMBO_KINDS;
+
+struct EndgameTableHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t solver_version;
+	uint32_t entry_size;
+	uint64_t action_fingerprint;
+	uint32_t count;
+	uint32_t steps;
+};
+
+struct EndgameKey {
+	int cp;			// Buckets
+	int durability;
+	int inner_quiet;
+	int innovation;
+	int great_strides;
+	int progress;	// Tenths of base progress to go
+	int combo;		// 1 after Basic Touch, 2 after Standard Touch or Observe
+};
+
+static int keyIndex(const EndgameKey& k) {
+	int idx = k.cp;
+	idx = idx * DURABILITY_BUCKETS + k.durability;
+	idx = idx * IQ_STACKS + k.inner_quiet;
+	idx = idx * INNOVATION_CHARGES + k.innovation;
+	idx = idx * GREAT_STRIDES_CHARGES + k.great_strides;
+	idx = idx * PROGRESS_BUCKETS + k.progress;
+	idx = idx * COMBO_KINDS + k.combo;
+	return idx;
+}
+
+static EndgameKey keyFromIndex(int idx) {
+	EndgameKey k;
+	k.combo = idx % COMBO_KINDS; idx /= COMBO_KINDS;
+	k.progress = idx % PROGRESS_BUCKETS; idx /= PROGRESS_BUCKETS;
+	k.great_strides = idx % GREAT_STRIDES_CHARGES; idx /= GREAT_STRIDES_CHARGES;
+	k.innovation = idx % INNOVATION_CHARGES; idx /= INNOVATION_CHARGES;
+	k.inner_quiet = idx % IQ_STACKS; idx /= IQ_STACKS;
+	k.durability = idx % DURABILITY_BUCKETS; idx /= DURABILITY_BUCKETS;
+	k.cp = idx;
+	return k;
+}
+
+static int comboKind(int used_action_idx) {
+	if (used_action_idx == BASIC_TOUCH) {
+		return 1;
+	}
+	if (used_action_idx == STANDARD_TOUCH || used_action_idx == OBSERVE) {
+		return 2;
+	}
+	return 0;
+}
+
+// Everything but progress, which the caller buckets against its own craft
+static EndgameKey keyOfState(const GameState& state, int progress_tenths) {
+	return EndgameKey{
+		.cp = state.cp / ENDGAME_CP_STEP,
+		.durability = std::min(ENDGAME_MAX_DURABILITY, state.durability) / 5,
+		.inner_quiet = std::min(10, (int)state.effects[E_INNER_QUIET].n_stacks),
+		.innovation = std::min(INNOVATION_CHARGES - 1, (int)state.effects[E_INNOVATION].n_charges),
+		.great_strides = std::min(GREAT_STRIDES_CHARGES - 1, (int)state.effects[E_GREAT_STRIDES].n_charges),
+		.progress = progress_tenths,
+		.combo = comboKind(state.used_action_idx)
+	};
+}
+
+bool openEndgameTable(const char* path, EndgameTable& table) {
+	table = EndgameTable();
+	if (!mapFileRead(path, table.file)) {
+		return false;
+	}
+	const EndgameTableHeader* header = (const EndgameTableHeader*)table.file.data;
+	if (table.file.size < sizeof(EndgameTableHeader)
+		|| header->magic != ENDGAME_TABLE_MAGIC
+		|| header->version != ENDGAME_TABLE_VERSION
+		|| header->solver_version != SOLVER_VERSION
+		|| header->entry_size != sizeof(EndgameEntry)
+		|| header->action_fingerprint != actionFingerprint()
+		|| header->count != ENDGAME_ENTRY_COUNT
+		|| header->steps != ENDGAME_STEPS
+		|| table.file.size < sizeof(EndgameTableHeader) + (size_t)header->count * sizeof(EndgameEntry)
+	) {
+		unmapFile(table.file);
+		return false;
+	}
+	table.entries = (const EndgameEntry*)(header + 1);
+	table.count = header->count;
+	// Rollouts play entries as they are, so they have to hold real actions
+	for (int i = 0; i < table.count; ++i) {
+		const EndgameEntry& e = table.entries[i];
+		bool ok = e.len <= ENDGAME_STEPS;
+		for (int j = 0; ok && j < e.len; ++j) {
+			ok = e.actions[j] < ACTION_COUNT;
+		}
+		if (!ok) {
+			closeEndgameTable(table);
+			return false;
+		}
+	}
+	adviseMappedRange(table.file, 0, table.file.size, MA_RANDOM);
+	return true;
+}
+
+void closeEndgameTable(EndgameTable& table) {
+	unmapFile(table.file);
+	table = EndgameTable();
+}
+
+const EndgameEntry* lookupEndgame(const EndgameTable& table, const GameContext& ctx, const GameState& state) {
+	if (!table.entries || state.cp / ENDGAME_CP_STEP >= CP_BUCKETS
+		|| state.durability <= 0 || state.progress >= ctx.target_progress) {
+		return 0;
+	}
+	int64_t to_go = (int64_t)(ctx.target_progress - state.progress) * 10;
+	int progress_tenths = (int)((to_go + ctx.base_progress_increase - 1) / ctx.base_progress_increase);
+	if (progress_tenths > ENDGAME_MAX_PROGRESS_TENTHS) {
+		return 0;
+	}
+	const EndgameEntry* e = &table.entries[keyIndex(keyOfState(state, progress_tenths))];
+	return e->quality_gain < 0 ? 0 : e;
+}
+
+// Best finisher from the state 'idx' stands for, given the finishers one step shorter
+static EndgameEntry solveEntry(int idx, const std::vector<EndgameEntry>& shorter) {
+	EndgameEntry best = { .quality_gain = -1, .len = 0 };
+	EndgameKey k = keyFromIndex(idx);
+	if (k.durability == 0 || k.progress == 0) {
+		return best;
+	}
+	const GameContext ctx = {
+		.base_progress_increase = 100,
+		.base_quality_increase = 100,
+		.max_cp = ENDGAME_MAX_CP,
+		.target_progress = k.progress * 10,
+		.target_quality = 1'000'000,
+		.max_durability = ENDGAME_MAX_DURABILITY
+	};
+	GameState state{};
+	state.progress = 0;
+	state.quality = 0;
+	state.durability = k.durability * 5;
+	state.cp = k.cp * ENDGAME_CP_STEP;
+	state.step = 1;
+	state.used_action_idx = k.combo == 1 ? BASIC_TOUCH : (k.combo == 2 ? STANDARD_TOUCH : -1);
+	state.trained_perfection_charges = 0;
+	state.effects[E_INNER_QUIET].n_stacks = k.inner_quiet;
+	state.effects[E_INNOVATION].n_charges = k.innovation;
+	state.effects[E_GREAT_STRIDES].n_charges = k.great_strides;
+
+	for (int a = 0; a < ACTION_COUNT; ++a) {
+		if (!canExecuteAction(ctx, state, (ACTION)a)) {
+			continue;
+		}
+		GameState next{};
+		next.inheritState(state);
+		applyAction(ctx, next, (ACTION)a);
+
+		EndgameEntry candidate = { .quality_gain = (int16_t)next.quality, .len = 1 };
+		candidate.actions[0] = (uint8_t)a;
+		if (next.progress < ctx.target_progress) {
+			if (next.durability <= 0) {
+				continue;
+			}
+			int progress_tenths = (ctx.target_progress - next.progress + 9) / 10;
+			const EndgameEntry& rest = shorter[keyIndex(keyOfState(next, progress_tenths))];
+			if (rest.quality_gain < 0) {
+				continue;
+			}
+			candidate.quality_gain += rest.quality_gain;
+			candidate.len += rest.len;
+			memcpy(candidate.actions + 1, rest.actions, rest.len);
+		}
+		if (candidate.quality_gain > best.quality_gain
+			|| (candidate.quality_gain == best.quality_gain && candidate.len < best.len)) {
+			best = candidate;
+		}
+	}
+	return best;
+}
+
+bool buildEndgameTable(const char* path, int n_threads) {
+	n_threads = std::max(1, n_threads);
+	// Finishers of up to h steps are built from those of up to h - 1
+	std::vector<EndgameEntry> shorter(ENDGAME_ENTRY_COUNT, EndgameEntry{ .quality_gain = -1, .len = 0 });
+	std::vector<EndgameEntry> longer(ENDGAME_ENTRY_COUNT);
+	for (int h = 1; h <= ENDGAME_STEPS; ++h) {
+		std::vector<std::thread> threads;
+		for (int t = 0; t < n_threads; ++t) {
+			threads.emplace_back([t, n_threads, &shorter, &longer]() {
+				for (int i = t; i < ENDGAME_ENTRY_COUNT; i += n_threads) {
+					longer[i] = solveEntry(i, shorter);
+				}
+			});
+		}
+		for (std::thread& t : threads) {
+			t.join();
+		}
+		std::swap(shorter, longer);
+		printf("Endgame table: %i/%i steps\n", h, ENDGAME_STEPS);
+	}
+
+	FILE* out = fopen(path, "wb");
+	if (!out) {
+		return false;
+	}
+	EndgameTableHeader header = {
+		.magic = ENDGAME_TABLE_MAGIC,
+		.version = ENDGAME_TABLE_VERSION,
+		.solver_version = SOLVER_VERSION,
+		.entry_size = sizeof(EndgameEntry),
+		.action_fingerprint = actionFingerprint(),
+		.count = ENDGAME_ENTRY_COUNT,
+		.steps = ENDGAME_STEPS
+	};
+	bool ok = fwrite(&header, sizeof(header), 1, out) == 1
+		&& fwrite(shorter.data(), sizeof(EndgameEntry), shorter.size(), out) == shorter.size();
+	ok = (fclose(out) == 0) && ok;
+	return ok;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include "game_config.hpp"
+#include "game_state.hpp"
+#include "mapped_file.hpp"
+
+
+// Endgame tablebase: the best quality a craft can still gain while finishing within
+// ENDGAME_STEPS actions, for every small endgame state. A state is keyed by
+// CP (floored to ENDGAME_CP_STEP), durability (floored to 5), Inner Quiet stacks,
+// Innovation and Great Strides charges, progress to go in tenths of base progress
+// (rounded up) and whether the last action opens a touch combo.
+// Everything else (Waste Not, Manipulation, Veneration, Trained Perfection) is taken
+// as absent, which only ever makes an entry pessimistic. Entries are solved exactly on
+// a craft with base progress and quality of 100, so a gain is in hundredths of base quality.
+// The file is a header and a flat array of entries, mapped read-only
+
+constexpr int ENDGAME_STEPS = 5;
+constexpr int ENDGAME_CP_STEP = 4;
+constexpr int ENDGAME_MAX_CP = 96;
+constexpr int ENDGAME_MAX_DURABILITY = 40;
+constexpr int ENDGAME_MAX_PROGRESS_TENTHS = 30;
+
+struct EndgameEntry {
+	int16_t quality_gain;	// -1 if the craft can't be finished in time
+	uint8_t len;
+	uint8_t actions[ENDGAME_STEPS];
+};
+
+struct EndgameTable {
+	MappedFile file;
+	const EndgameEntry* entries = 0;
+	int count = 0;
+};
+
+bool openEndgameTable(const char* path, EndgameTable& table);
+void closeEndgameTable(EndgameTable& table);
+
+// Best finisher for 'state', or null if it is outside the table or can't be finished
+const EndgameEntry* lookupEndgame(const EndgameTable& table, const GameContext& ctx, const GameState& state);
+
+// Solves every entry, n_threads at a time. Takes a few seconds per thread
+bool buildEndgameTable(const char* path, int n_threads);
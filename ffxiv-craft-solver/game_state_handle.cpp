@@ -1,77 +1,470 @@
-#include "game_state_handle.hpp"
-
-#include <assert.h>
-#include <array>
-#include <set>
-
-#include "game_state.hpp"
-
-
-int MAX_STATES = 0;
-
-//static std::array<GameState, MAX_STATES> state_pool;
-static GameState* state_pool = 0;
-static int insert_idx = 0;
-static std::set<int> free_slots;
-
-
-GameState* HGAME_STATE::deref() {
-	return &state_pool[pool_idx];
-}
-const GameState* HGAME_STATE::deref() const {
-	return &state_pool[pool_idx];
-}
-
-GameState* HGAME_STATE::operator->() {
-	return &state_pool[pool_idx];
-}
-const GameState* HGAME_STATE::operator->() const {
-	return &state_pool[pool_idx];
-}
-GameState& HGAME_STATE::operator*() {
-	return state_pool[pool_idx];
-}
-const GameState& HGAME_STATE::operator*() const {
-	return state_pool[pool_idx];
-}
-bool HGAME_STATE::operator==(const HGAME_STATE& other) const {
-	return this->pool_idx == other.pool_idx;
-}
-
-static int n_allocated_states = 0;
-
-void initGameStatePool(int count) {
-	MAX_STATES = count;
-	state_pool = new GameState[count];
-}
-
-HGAME_STATE createGameState(const GameState& other, bool keep_score) {
-	if (!free_slots.empty()) {
-		int slot = *free_slots.begin();
-		free_slots.erase(slot);
-		state_pool[slot].inheritState(other, keep_score);
-		++n_allocated_states;
-		return HGAME_STATE(slot);
-	}
-
-	if (insert_idx == MAX_STATES) {
-		assert(false);
-		return HGAME_STATE();
-	}
-
-	int pool_idx = insert_idx;
-	state_pool[insert_idx].inheritState(other, keep_score);
-	++n_allocated_states;
-	return HGAME_STATE(insert_idx++);
-}
-void freeGameState(HGAME_STATE hstate) {
-	assert(hstate.isValid());
-	//state_pool[state->pool_idx] = GameState();
-	//memset(hstate.deref(), 0xAB, sizeof(GameState));
-	--n_allocated_states;
-	free_slots.insert(hstate.getIdx());
-}
-
-int getAllocatedStatesCount() {
-	return n_allocated_states;
-}
\ No newline at end of file
+#include "game_state_handle.hpp"
+
+#include <assert.h>
+#include <algorithm>
+#include <array>
+#include <set>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <new>
+#include <string>
+
+#include "actions.hpp"
+#include "combo_set.hpp"
+#include "game_state.hpp"
+#include "mapped_file.hpp"
+#include "profiler.hpp"
+
+
+struct GameStatePool {
+	int max_states = 0;
+
+	GameState* state_pool = 0;
+	int insert_idx = 0;
+	std::set<int> free_slots;
+	int n_allocated_states = 0;
+
+	// Out-of-core backend: slots past resident_count live in a memory-mapped spill file.
+	// Without a spill file resident_count == max_states and everything is in state_pool
+	int resident_count = 0;
+	GameState* spill_pool = 0;
+	MappedFile spill_file;
+	std::string spill_path;		// Removed with the pool
+	// Spill slots are constructed when first handed out, so pages nobody used stay untouched
+	int n_spill_constructed = 0;
+};
+
+// Handles carry only an index, this is the pool they resolve against
+static thread_local GameStatePool* pool = 0;
+
+static inline GameState* poolSlot(int idx) {
+	if (idx < pool->resident_count) {
+		return &pool->state_pool[idx];
+	}
+	return &pool->spill_pool[idx - pool->resident_count];
+}
+
+// poolSlot() for a slot that may never have been handed out before
+static GameState* firstUseSlot(int idx) {
+	int spill_idx = idx - pool->resident_count;
+	while (pool->n_spill_constructed <= spill_idx) {
+		new (&pool->spill_pool[pool->n_spill_constructed++]) GameState();
+	}
+	return poolSlot(idx);
+}
+
+
+GameState* HGAME_STATE::deref() {
+	return poolSlot(pool_idx);
+}
+const GameState* HGAME_STATE::deref() const {
+	return poolSlot(pool_idx);
+}
+
+GameState* HGAME_STATE::operator->() {
+	return poolSlot(pool_idx);
+}
+const GameState* HGAME_STATE::operator->() const {
+	return poolSlot(pool_idx);
+}
+GameState& HGAME_STATE::operator*() {
+	return *poolSlot(pool_idx);
+}
+const GameState& HGAME_STATE::operator*() const {
+	return *poolSlot(pool_idx);
+}
+bool HGAME_STATE::operator==(const HGAME_STATE& other) const {
+	return this->pool_idx == other.pool_idx;
+}
+
+GameStatePool* createGameStatePool(int count) {
+	GameStatePool* p = new GameStatePool;
+	p->max_states = count;
+	p->resident_count = count;
+	p->state_pool = new GameState[count];
+	return p;
+}
+
+GameStatePool* createGameStatePoolSpilled(int count, int n_resident, const char* spill_path) {
+	n_resident = std::clamp(n_resident, 0, count);
+	int n_spilled = count - n_resident;
+	GameStatePool* p = new GameStatePool;
+	if (n_spilled > 0) {
+		if (!mapFileReadWrite(spill_path, (size_t)n_spilled * sizeof(GameState), p->spill_file)) {
+			remove(spill_path);
+			delete p;
+			return 0;
+		}
+		p->spill_pool = (GameState*)p->spill_file.data;
+		p->spill_path = spill_path;
+		// Cold nodes are touched in no particular order, readahead only wastes memory
+		adviseMappedRange(p->spill_file, 0, p->spill_file.size, MA_RANDOM);
+	}
+
+	p->max_states = count;
+	p->resident_count = n_resident;
+	p->state_pool = new GameState[n_resident];
+	return p;
+}
+
+void destroyGameStatePool(GameStatePool* p) {
+	if (!p) {
+		return;
+	}
+	if (pool == p) {
+		pool = 0;
+	}
+	delete[] p->state_pool;
+	for (int i = 0; i < p->n_spill_constructed; ++i) {
+		p->spill_pool[i].~GameState();
+	}
+	if (p->spill_pool) {
+		unmapFile(p->spill_file);
+		remove(p->spill_path.c_str());
+	}
+	delete p;
+}
+
+GameStatePool* bindGameStatePool(GameStatePool* p) {
+	GameStatePool* prev = pool;
+	pool = p;
+	return prev;
+}
+
+void resetGameStatePool() {
+	pool->insert_idx = 0;
+	pool->n_allocated_states = 0;
+	pool->free_slots.clear();
+}
+
+HGAME_STATE createGameState(const GameState& other, bool keep_score) {
+	PROFILE_COUNT(PC_ALLOC_CALLS, 1);
+	if (!pool->free_slots.empty()) {
+		int slot = *pool->free_slots.begin();
+		pool->free_slots.erase(slot);
+		poolSlot(slot)->resetSearchState();
+		poolSlot(slot)->inheritState(other, keep_score);
+		++pool->n_allocated_states;
+		return HGAME_STATE(slot);
+	}
+
+	if (pool->insert_idx == pool->max_states) {
+		assert(false);
+		return HGAME_STATE();
+	}
+
+	int pool_idx = pool->insert_idx;
+	firstUseSlot(pool_idx)->resetSearchState();
+	poolSlot(pool_idx)->inheritState(other, keep_score);
+	++pool->n_allocated_states;
+	return HGAME_STATE(pool->insert_idx++);
+}
+void freeGameState(HGAME_STATE hstate) {
+	assert(hstate.isValid());
+	PROFILE_COUNT(PC_FREE_CALLS, 1);
+	//state_pool[state->pool_idx] = GameState();
+	//memset(hstate.deref(), 0xAB, sizeof(GameState));
+	--pool->n_allocated_states;
+	pool->free_slots.insert(hstate.getIdx());
+}
+
+void appendChild(HGAME_STATE parent, HGAME_STATE child) {
+	child->next_sibling = HGAME_STATE();
+	if (!parent->first_child.isValid()) {
+		parent->first_child = child;
+	} else {
+		HGAME_STATE last = parent->first_child;
+		while (last->next_sibling.isValid()) {
+			last = last->next_sibling;
+		}
+		last->next_sibling = child;
+	}
+	++parent->n_children;
+}
+void removeChild(HGAME_STATE parent, HGAME_STATE child) {
+	if (parent->first_child == child) {
+		parent->first_child = child->next_sibling;
+	} else {
+		HGAME_STATE prev = parent->first_child;
+		while (!(prev->next_sibling == child)) {
+			prev = prev->next_sibling;
+		}
+		prev->next_sibling = child->next_sibling;
+	}
+	child->next_sibling = HGAME_STATE();
+	--parent->n_children;
+}
+
+int getAllocatedStatesCount() {
+	return pool->n_allocated_states;
+}
+int getGameStatePoolCapacity() {
+	return pool->max_states;
+}
+int getGameStatePoolHighWater() {
+	return pool->insert_idx;
+}
+int getFreeSlotCount() {
+	return (int)pool->free_slots.size();
+}
+
+struct GameStatePoolHeader {
+	int32_t capacity;
+	int32_t insert_idx;
+	int32_t n_allocated;
+	int32_t n_free;
+};
+
+struct GameStateRecord {
+	int32_t parent;
+	int32_t progress;
+	int32_t quality;
+	int32_t durability;
+	int32_t cp;
+	int32_t step;
+	int32_t used_action_idx;
+	int32_t combo_depth;
+	EffectState effects[EFFECT_COUNT];
+	int32_t trained_perfection_charges;
+	double score;
+	double max_score;
+	double sum_of_squared_score;
+	double amaf_score;
+	int32_t amaf_visits;
+	int32_t cp_used_on_progress;
+	int32_t durability_used_on_progress;
+	int32_t cp_used_on_quality;
+	int32_t durability_used_on_quality;
+	int32_t wasted_durability;
+	int32_t n_visits;
+	int32_t next_action_to_explore;
+	int32_t n_possible_moves;
+	uint32_t actions_expanded; // bit per ACTION
+	uint32_t combos_expanded;
+	int32_t in_combo;
+	uint32_t n_children;       // followed by n_children int32 pool indices
+};
+static_assert(ACTION_COUNT <= 32, "actions_expanded mask is too narrow");
+
+bool writeGameStatePool(FILE* f) {
+	GameStatePoolHeader header = {
+		.capacity = pool->max_states,
+		.insert_idx = pool->insert_idx,
+		.n_allocated = pool->n_allocated_states,
+		.n_free = (int32_t)pool->free_slots.size()
+	};
+	if (fwrite(&header, sizeof(header), 1, f) != 1) {
+		return false;
+	}
+
+	// Freed slots keep stale child links into nodes that moved on, they are written childless
+	std::vector<bool> is_free(pool->insert_idx);
+	for (int idx : pool->free_slots) {
+		is_free[idx] = true;
+	}
+	std::vector<int32_t> children;
+	for (int i = 0; i < pool->insert_idx; ++i) {
+		const GameState& st = *poolSlot(i);
+		GameStateRecord rec = { 0 };
+		rec.parent = st.parent.getIdx();
+		rec.progress = st.progress;
+		rec.quality = st.quality;
+		rec.durability = st.durability;
+		rec.cp = st.cp;
+		rec.step = st.step;
+		rec.used_action_idx = st.used_action_idx;
+		rec.combo_depth = st.combo_depth;
+		memcpy(rec.effects, st.effects, sizeof(rec.effects));
+		rec.trained_perfection_charges = st.trained_perfection_charges;
+		rec.score = (double)st.score;
+		rec.max_score = (double)st.max_score;
+		rec.sum_of_squared_score = (double)st.sum_of_squared_score;
+		rec.amaf_score = (double)st.amaf_score;
+		rec.amaf_visits = st.amaf_visits;
+		rec.cp_used_on_progress = st.cp_used_on_progress;
+		rec.durability_used_on_progress = st.durability_used_on_progress;
+		rec.cp_used_on_quality = st.cp_used_on_quality;
+		rec.durability_used_on_quality = st.durability_used_on_quality;
+		rec.wasted_durability = st.wasted_durability;
+		rec.n_visits = st.n_visits;
+		rec.next_action_to_explore = st.next_action_to_explore;
+		rec.n_possible_moves = st.n_possible_moves;
+		rec.actions_expanded = st.actions_expanded;
+		rec.combos_expanded = st.combos_expanded;
+		rec.in_combo = st.in_combo;
+		children.clear();
+		for (HGAME_STATE ch = st.first_child; ch.isValid() && !is_free[i]; ch = ch->next_sibling) {
+			children.push_back(ch.getIdx());
+		}
+		rec.n_children = (uint32_t)children.size();
+		if (fwrite(&rec, sizeof(rec), 1, f) != 1) {
+			return false;
+		}
+		if (!children.empty() && fwrite(children.data(), sizeof(int32_t), children.size(), f) != children.size()) {
+			return false;
+		}
+	}
+
+	for (int idx : pool->free_slots) {
+		int32_t slot = idx;
+		if (fwrite(&slot, sizeof(slot), 1, f) != 1) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool readBytes(const uint8_t*& cursor, const uint8_t* end, void* dst, size_t size) {
+	if (end - cursor < (ptrdiff_t)size) {
+		return false;
+	}
+	memcpy(dst, cursor, size);
+	cursor += size;
+	return true;
+}
+
+// Effect values no action can produce, see actions.hpp
+static bool effectsInRange(const EffectState* effects) {
+	int max_charges = 0;
+	for (const Action& action : actions) {
+		max_charges = std::max(max_charges, action.effect_charges);
+	}
+	for (int e = 0; e < EFFECT_COUNT; ++e) {
+		if (effects[e].n_stacks > 10 || effects[e].n_charges > max_charges) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool readGameStatePool(const uint8_t*& cursor, const uint8_t* end) {
+	GameStatePoolHeader header;
+	if (!readBytes(cursor, end, &header, sizeof(header))) {
+		return false;
+	}
+	if (header.insert_idx < 0 || header.insert_idx > pool->max_states
+		|| header.n_free < 0 || header.n_free > header.insert_idx
+		|| header.n_allocated != header.insert_idx - header.n_free) {
+		return false;
+	}
+	// Nothing read from the file is trusted to point inside the pool
+	auto inPool = [&header](int32_t idx) {
+		return idx >= 0 && idx < header.insert_idx;
+	};
+
+	// First pass only checks, so a bad file leaves the live pool as it was
+	const uint8_t* records = cursor;
+	std::vector<int32_t> parents(header.insert_idx);
+	std::vector<int32_t> steps(header.insert_idx);
+	std::vector<int32_t> children;
+	std::vector<uint32_t> first_child(header.insert_idx + 1);
+	for (int i = 0; i < header.insert_idx; ++i) {
+		GameStateRecord rec;
+		if (!readBytes(cursor, end, &rec, sizeof(rec))) {
+			return false;
+		}
+		// Every action plus every combo is as wide as a node gets
+		if ((rec.parent != -1 && !inPool(rec.parent))
+			|| rec.used_action_idx < -1 || rec.used_action_idx >= ACTION_COUNT
+			|| rec.step < 0
+			|| !effectsInRange(rec.effects)
+			|| rec.n_children > ACTION_COUNT + COMBO_SET_MAX
+			|| (size_t)(end - cursor) < rec.n_children * sizeof(int32_t)) {
+			return false;
+		}
+		parents[i] = rec.parent;
+		steps[i] = rec.step;
+		first_child[i] = (uint32_t)children.size();
+		for (uint32_t j = 0; j < rec.n_children; ++j) {
+			int32_t child = -1;
+			readBytes(cursor, end, &child, sizeof(child));
+			if (!inPool(child)) {
+				return false;
+			}
+			children.push_back(child);
+		}
+	}
+	first_child[header.insert_idx] = (uint32_t)children.size();
+
+	std::vector<bool> is_free(header.insert_idx);
+	std::vector<int32_t> free_slots(header.n_free);
+	for (int i = 0; i < header.n_free; ++i) {
+		if (!readBytes(cursor, end, &free_slots[i], sizeof(int32_t)) || !inPool(free_slots[i]) || is_free[free_slots[i]]) {
+			return false;
+		}
+		is_free[free_slots[i]] = true;
+	}
+
+	// Freed slots keep stale data. Live nodes must form a tree: roots at step 0, every node one
+	// step below its parent, which also rules out cycles, and every child listed once, pointing back
+	std::vector<bool> listed(header.insert_idx);
+	for (int i = 0; i < header.insert_idx; ++i) {
+		if (is_free[i]) {
+			continue;
+		}
+		int32_t parent = parents[i];
+		if (parent == -1 ? steps[i] != 0 : (is_free[parent] || steps[parent] != steps[i] - 1)) {
+			return false;
+		}
+		for (uint32_t j = first_child[i]; j < first_child[i + 1]; ++j) {
+			if (is_free[children[j]] || parents[children[j]] != i || listed[children[j]]) {
+				return false;
+			}
+			listed[children[j]] = true;
+		}
+	}
+
+	cursor = records;
+	for (int i = 0; i < header.insert_idx; ++i) {
+		GameStateRecord rec;
+		readBytes(cursor, end, &rec, sizeof(rec));
+		GameState& st = *firstUseSlot(i);
+		st.parent = HGAME_STATE(rec.parent);
+		st.progress = rec.progress;
+		st.quality = rec.quality;
+		st.durability = rec.durability;
+		st.cp = rec.cp;
+		st.step = rec.step;
+		st.used_action_idx = rec.used_action_idx;
+		st.combo_depth = rec.combo_depth;
+		memcpy(st.effects, rec.effects, sizeof(st.effects));
+		st.trained_perfection_charges = rec.trained_perfection_charges;
+		st.score = rec.score;
+		st.max_score = rec.max_score;
+		st.sum_of_squared_score = rec.sum_of_squared_score;
+		st.amaf_score = rec.amaf_score;
+		st.amaf_visits = rec.amaf_visits;
+		st.cp_used_on_progress = rec.cp_used_on_progress;
+		st.durability_used_on_progress = rec.durability_used_on_progress;
+		st.cp_used_on_quality = rec.cp_used_on_quality;
+		st.durability_used_on_quality = rec.durability_used_on_quality;
+		st.wasted_durability = rec.wasted_durability;
+		st.n_visits = rec.n_visits;
+		st.next_action_to_explore = rec.next_action_to_explore;
+		st.n_possible_moves = rec.n_possible_moves;
+		st.actions_expanded = rec.actions_expanded & ((1ull << ACTION_COUNT) - 1);
+		st.combos_expanded = rec.combos_expanded;
+		st.in_combo = rec.in_combo != 0;
+		st.n_children = is_free[i] ? 0 : (int)rec.n_children;
+		st.first_child = st.n_children ? HGAME_STATE(children[first_child[i]]) : HGAME_STATE();
+		st.next_sibling = HGAME_STATE();
+		cursor += rec.n_children * sizeof(int32_t);
+	}
+	// Siblings are linked once every slot is written
+	for (int i = 0; i < header.insert_idx; ++i) {
+		if (is_free[i]) {
+			continue;
+		}
+		for (uint32_t j = first_child[i]; j < first_child[i + 1]; ++j) {
+			poolSlot(children[j])->next_sibling = j + 1 < first_child[i + 1] ? HGAME_STATE(children[j + 1]) : HGAME_STATE();
+		}
+	}
+	cursor += header.n_free * sizeof(int32_t);
+
+	pool->free_slots.clear();
+	pool->free_slots.insert(free_slots.begin(), free_slots.end());
+	pool->insert_idx = header.insert_idx;
+	pool->n_allocated_states = header.n_allocated;
+	return true;
+}
@@ -1,39 +1,70 @@
-#pragma once
-
-#include "common.hpp"
-
-struct GameState;
-
-class HGAME_STATE {
-	int pool_idx;
-public:
-	HGAME_STATE()
-		: pool_idx(-1) {}
-	HGAME_STATE(int idx)
-		: pool_idx(idx) {}
-
-	int getIdx() const { return pool_idx; }
-	/*
-	operator bool() const {
-		return pool_idx != -1;
-	}*/
-
-	bool isValid() const { return pool_idx >= 0; }
-
-	GameState* deref();
-	const GameState* deref() const;
-
-	GameState* operator->();
-	const GameState* operator->() const;
-	GameState& operator*();
-	const GameState& operator*() const;
-	bool operator==(const HGAME_STATE& other) const;
-};
-
-
-void initGameStatePool(int count);
-
-HGAME_STATE createGameState(const GameState& other, bool keep_score = false);
-void freeGameState(HGAME_STATE hstate);
-
-int getAllocatedStatesCount();
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include "common.hpp"
+
+struct GameState;
+
+class HGAME_STATE {
+	int pool_idx;
+public:
+	HGAME_STATE()
+		: pool_idx(-1) {}
+	HGAME_STATE(int idx)
+		: pool_idx(idx) {}
+
+	int getIdx() const { return pool_idx; }
+	/*
+	operator bool() const {
+		return pool_idx != -1;
+	}*/
+
+	bool isValid() const { return pool_idx >= 0; }
+
+	GameState* deref();
+	const GameState* deref() const;
+
+	GameState* operator->();
+	const GameState* operator->() const;
+	GameState& operator*();
+	const GameState& operator*() const;
+	bool operator==(const HGAME_STATE& other) const;
+};
+
+
+struct GameStatePool;
+
+GameStatePool* createGameStatePool(int count);
+// Keeps the first n_resident slots in RAM and backs the rest with a memory-mapped file.
+// Slots are handed out lowest index first, so the upper tree ends up resident.
+// The file is scratch space, removed again by destroyGameStatePool.
+// Returns null if the spill file can't be created
+GameStatePool* createGameStatePoolSpilled(int count, int n_resident, const char* spill_path);
+void destroyGameStatePool(GameStatePool* pool);
+
+// Handles and every function below work on the pool bound to the calling thread.
+// Returns the previously bound pool
+GameStatePool* bindGameStatePool(GameStatePool* pool);
+
+// Drops every node but keeps the memory, for reusing a pool between searches
+void resetGameStatePool();
+
+HGAME_STATE createGameState(const GameState& other, bool keep_score = false);
+void freeGameState(HGAME_STATE hstate);
+
+// A node's children, in the order they were added:
+//	for (HGAME_STATE ch = state->first_child; ch.isValid(); ch = ch->next_sibling)
+void appendChild(HGAME_STATE parent, HGAME_STATE child);
+void removeChild(HGAME_STATE parent, HGAME_STATE child);
+
+int getAllocatedStatesCount();
+int getGameStatePoolCapacity();
+// Highest slot ever handed out, i.e. the pool's high-water mark
+int getGameStatePoolHighWater();
+int getFreeSlotCount();
+
+// Checkpointing: dumps every slot up to the insert position plus the free list.
+// Reading requires a pool initialized with at least the saved capacity
+bool writeGameStatePool(FILE* f);
+bool readGameStatePool(const uint8_t*& cursor, const uint8_t* end);
@@ -0,0 +1,199 @@
+#include "genetic.hpp"
+
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include "actions.hpp"
+#include "portfolio.hpp"
+#include "solver.hpp"
+
+
+constexpr int GENOME_CAPACITY = 64;
+
+struct Genome {
+	ACTION genes[GENOME_CAPACITY];
+	int len;		// Genes decoding used, the rest are spare material for crossover
+	double fitness;
+};
+
+struct GeneticRun {
+	const GameContext& ctx;
+	const ProgressOracle& oracle;
+	const GameState& start;
+	const GeneticParams& params;
+};
+
+static bool keepsFinishable(const GeneticRun& run, const GameState& state, ACTION a, GameState& next) {
+	if (!canExecuteAction(run.ctx, state, a)) {
+		return false;
+	}
+	next.inheritState(state);
+	++next.step;
+	applyAction(run.ctx, next, a);
+	if (next.progress >= run.ctx.target_progress) {
+		return true;
+	}
+	int steps_left = run.params.max_steps - next.step;
+	return canStillFinish(run.oracle, next, steps_left) && !belowIncumbent(run.ctx, next, steps_left, run.params.limits.incumbent);
+}
+
+// Plays the genome from the start, repairing genes in place, and scores where it ends
+static void evaluate(const GeneticRun& run, Genome& g, std::mt19937& rng) {
+	GameState state{};
+	state.inheritState(run.start);
+	GameState next{};
+	ACTION moves[ACTION_COUNT];
+	for (int a = 0; a < ACTION_COUNT; ++a) {
+		moves[a] = (ACTION)a;
+	}
+	int i = 0;
+	while (i < GENOME_CAPACITY && state.step < run.params.max_steps
+		&& state.durability > 0 && state.progress < run.ctx.target_progress) {
+		// Moves tried in random order, the first that works is uniform over those that do
+		bool ok = keepsFinishable(run, state, g.genes[i], next);
+		for (int k = 0; !ok && k < ACTION_COUNT; ++k) {
+			std::swap(moves[k], moves[std::uniform_int_distribution<int>(k, ACTION_COUNT - 1)(rng)]);
+			ok = keepsFinishable(run, state, moves[k], next);
+			g.genes[i] = moves[k];
+		}
+		if (!ok) {
+			break;
+		}
+		state.inheritState(next);
+		++i;
+	}
+	g.len = i;
+	if (state.progress >= run.ctx.target_progress) {
+		g.fitness = 1.0 + (double)monteCarloScore(run.ctx, state);
+		if (run.params.limits.incumbent) {
+			raiseIncumbent(*run.params.limits.incumbent, state.quality);
+		}
+	} else {
+		g.fitness = state.progress / (double)run.ctx.target_progress;
+	}
+}
+
+static void randomGenes(ACTION* genes, int n, std::mt19937& rng) {
+	std::uniform_int_distribution<int> dist(0, ACTION_COUNT - 1);
+	for (int i = 0; i < n; ++i) {
+		genes[i] = (ACTION)dist(rng);
+	}
+}
+
+static const Genome& tournament(const GeneticRun& run, const std::vector<Genome>& population, std::mt19937& rng) {
+	std::uniform_int_distribution<int> dist(0, (int)population.size() - 1);
+	const Genome* best = &population[dist(rng)];
+	for (int i = 1; i < run.params.tournament; ++i) {
+		const Genome* g = &population[dist(rng)];
+		if (g->fitness > best->fitness) {
+			best = g;
+		}
+	}
+	return *best;
+}
+
+// Head of 'a' up to one cut, tail of 'b' from another, topped up with random genes
+static void crossover(const Genome& a, const Genome& b, Genome& child, std::mt19937& rng) {
+	int cut_a = std::uniform_int_distribution<int>(0, a.len)(rng);
+	int cut_b = std::uniform_int_distribution<int>(0, b.len)(rng);
+	int n = 0;
+	for (int i = 0; i < cut_a; ++i) {
+		child.genes[n++] = a.genes[i];
+	}
+	for (int i = cut_b; i < GENOME_CAPACITY && n < GENOME_CAPACITY; ++i) {
+		child.genes[n++] = b.genes[i];
+	}
+	randomGenes(child.genes + n, GENOME_CAPACITY - n, rng);
+}
+
+static void mutate(const GeneticRun& run, Genome& g, std::mt19937& rng) {
+	std::uniform_real_distribution<float> chance(.0f, 1.f);
+	std::uniform_int_distribution<int> action(0, ACTION_COUNT - 1);
+	int len = std::max(1, g.len);
+	std::uniform_int_distribution<int> at(0, len - 1);
+	if (chance(rng) < run.params.mutation_rate) {
+		g.genes[at(rng)] = (ACTION)action(rng);
+	}
+	if (chance(rng) < run.params.mutation_rate) {
+		int i = at(rng);
+		memmove(g.genes + i + 1, g.genes + i, (GENOME_CAPACITY - i - 1) * sizeof(ACTION));
+		g.genes[i] = (ACTION)action(rng);
+	}
+	if (chance(rng) < run.params.mutation_rate) {
+		// The last gene is kept as spare, removeFromSequence reads one past len
+		removeFromSequence(g.genes, GENOME_CAPACITY - 1, at(rng));
+	}
+	if (chance(rng) < run.params.mutation_rate && len > 1) {
+		int i = std::uniform_int_distribution<int>(0, len - 2)(rng);
+		std::swap(g.genes[i], g.genes[i + 1]);
+	}
+}
+
+// Genomes [from, size) split across threads, each with its own generator
+static void evaluateAll(const GeneticRun& run, std::vector<Genome>& population, int from, std::vector<std::mt19937>& rngs) {
+	int n_threads = (int)rngs.size();
+	if (n_threads == 1) {
+		for (int i = from; i < (int)population.size(); ++i) {
+			evaluate(run, population[i], rngs[0]);
+		}
+		return;
+	}
+	std::vector<std::thread> threads;
+	for (int t = 0; t < n_threads; ++t) {
+		threads.emplace_back([&run, &population, &rngs, from, n_threads, t]() {
+			for (int i = from + t; i < (int)population.size(); i += n_threads) {
+				evaluate(run, population[i], rngs[t]);
+			}
+		});
+	}
+	for (std::thread& t : threads) {
+		t.join();
+	}
+}
+
+GeneticResult solveByGenetic(const GameContext& ctx, const ProgressOracle& oracle, const GameState& start, const GeneticParams& params) {
+	GeneticParams clamped = params;
+	clamped.max_steps = std::min(params.max_steps, start.step + GENOME_CAPACITY);
+	clamped.population = std::max(2, params.population);
+	clamped.elite = std::clamp(params.elite, 1, clamped.population - 1);
+	clamped.tournament = std::max(1, params.tournament);
+	GeneticRun run = { .ctx = ctx, .oracle = oracle, .start = start, .params = clamped };
+
+	std::random_device seed;
+	std::mt19937 rng{ seed() };
+	std::vector<std::mt19937> rngs;
+	for (int t = 0; t < std::max(1, params.n_threads); ++t) {
+		rngs.emplace_back(seed());
+	}
+
+	std::vector<Genome> population(clamped.population);
+	for (Genome& g : population) {
+		randomGenes(g.genes, GENOME_CAPACITY, rng);
+	}
+	evaluateAll(run, population, 0, rngs);
+	int evaluations = clamped.population;
+	auto fitter = [](const Genome& a, const Genome& b) { return a.fitness > b.fitness; };
+	std::sort(population.begin(), population.end(), fitter);
+
+	std::vector<Genome> next(clamped.population);
+	for (int gen = 0; gen < clamped.generations && !searchLimitsReached(run.params.limits); ++gen) {
+		std::copy(population.begin(), population.begin() + clamped.elite, next.begin());
+		for (int i = clamped.elite; i < clamped.population; ++i) {
+			crossover(tournament(run, population, rng), tournament(run, population, rng), next[i], rng);
+			mutate(run, next[i], rng);
+		}
+		evaluateAll(run, next, clamped.elite, rngs);
+		evaluations += clamped.population - clamped.elite;
+		std::swap(population, next);
+		std::sort(population.begin(), population.end(), fitter);
+	}
+
+	const Genome& best = population[0];
+	GeneticResult result;
+	result.found = best.fitness >= 1.0;
+	result.fitness = best.fitness;
+	result.actions.assign(best.genes, best.genes + best.len);
+	result.evaluations = evaluations;
+	return result;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+#include "game_config.hpp"
+#include "game_state.hpp"
+#include "progress_oracle.hpp"
+#include "search_limits.hpp"
+
+
+// Genetic algorithm over fixed-capacity action arrays. A genome is decoded by simulating it
+// from the start on a plain GameState, so no pool is touched: a gene that can't execute, or
+// that would leave progress out of reach by the oracle or quality below the incumbent, is
+// repaired in place with a random move that can. Fitness is monteCarloScore of the state decoding ends in, with finished crafts
+// always above unfinished ones. Each generation keeps the elite, breeds the rest by tournament,
+// cut-and-splice crossover and point, insert, delete and swap mutations, and is evaluated
+// across n_threads
+struct GeneticParams {
+	int population = 256;
+	int generations = 200;
+	int max_steps = 26;
+	int elite = 4;
+	int tournament = 3;
+	float mutation_rate = .3f;	// Chance of each mutation kind per child
+	int n_threads = 1;
+	// Early stop, the best genome so far is returned
+	SearchLimits limits;
+};
+
+struct GeneticResult {
+	bool found = false;		// The best genome reaches target_progress
+	double fitness = .0;
+	std::vector<ACTION> actions;
+	int evaluations = 0;
+};
+
+// Evolves sequences from 'start' with an oracle built for ctx
+GeneticResult solveByGenetic(const GameContext& ctx, const ProgressOracle& oracle, const GameState& start, const GeneticParams& params);
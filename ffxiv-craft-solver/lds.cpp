@@ -0,0 +1,328 @@
+#include "lds.hpp"
+
+#include <string.h>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include "actions.hpp"
+#include "portfolio.hpp"
+#include "solver.hpp"
+
+
+constexpr int LDS_MAX_STEPS = 64;
+// Dominance entries a worker keeps before starting its table over
+constexpr size_t LDS_MAX_SEEN = 1 << 20;
+
+// Everything but quality, so states that only differ in it can be compared
+struct LdsKey {
+	int progress;
+	int durability;
+	int cp;
+	int step;
+	int used_action_idx;
+	int trained_perfection_charges;
+	EffectState effects[EFFECT_COUNT];
+
+	bool operator==(const LdsKey& other) const {
+		return memcmp(this, &other, sizeof(LdsKey)) == 0;
+	}
+};
+
+struct LdsKeyHash {
+	size_t operator()(const LdsKey& key) const {
+		// FNV-1a
+		uint64_t h = 14695981039346656037ull;
+		const uint8_t* p = (const uint8_t*)&key;
+		for (size_t i = 0; i < sizeof(LdsKey); ++i) {
+			h = (h ^ p[i]) * 1099511628211ull;
+		}
+		return (size_t)h;
+	}
+};
+
+// Visits of a key none of which has both more quality and more discrepancies left than another.
+// Merging two into one would claim a visit that never happened. Once full, new ones aren't
+// recorded, which only prunes less
+constexpr int LDS_SEEN_PER_KEY = 4;
+
+struct LdsSeen {
+	int quality;
+	int discrepancies;
+};
+
+struct LdsFront {
+	int n = 0;
+	LdsSeen visits[LDS_SEEN_PER_KEY];
+};
+
+struct LdsLine {
+	long double score = -1.L;
+	int len = 0;
+	ACTION actions[LDS_MAX_STEPS];
+};
+
+struct LdsRun {
+	const GameContext& ctx;
+	const ProgressOracle& oracle;
+	const GameState& start;
+	const LdsParams& params;
+	std::atomic<int>* incumbent;
+	std::atomic<int> lines{ 0 };
+};
+
+// Search state of one thread. Its dominance table lives across passes
+struct LdsWorker {
+	LdsWorker(LdsRun& run) : run(run), states(new GameState[LDS_MAX_STEPS + 1]) {}
+
+	LdsRun& run;
+	std::unique_ptr<GameState[]> states;	// One per depth below the start
+	GameState scratch;
+	ACTION path[LDS_MAX_STEPS];
+	LdsLine best;
+	std::unordered_map<LdsKey, LdsFront, LdsKeyHash> seen;
+	int n_nodes = 0;
+	bool stopped = false;
+};
+
+static LdsKey keyOf(const GameState& state) {
+	LdsKey key;
+	memset(&key, 0, sizeof(key));
+	key.progress = state.progress;
+	key.durability = state.durability;
+	key.cp = state.cp;
+	key.step = state.step;
+	key.used_action_idx = state.used_action_idx;
+	key.trained_perfection_charges = state.trained_perfection_charges;
+	memcpy(key.effects, state.effects, sizeof(key.effects));
+	return key;
+}
+
+// Moves the heuristic weighs above zero, best first. Its weights are coarse, so ties go to
+// the quality potential of where each move leads
+static int rankMoves(LdsWorker& w, int depth, ACTION* moves) {
+	const LdsRun& run = w.run;
+	const GameState& state = w.states[depth];
+	float weights[ACTION_COUNT];
+	for (int a = 0; a < ACTION_COUNT; ++a) {
+		weights[a] = canExecuteAction(run.ctx, state, (ACTION)a) ? 1.f : .0f;
+	}
+	assignActionWeights(run.ctx, state, weights);
+	float potential[ACTION_COUNT];
+	int n = 0;
+	for (int a = 0; a < ACTION_COUNT; ++a) {
+		if (weights[a] <= .0f || !canExecuteAction(run.ctx, state, (ACTION)a)) {
+			continue;
+		}
+		w.scratch.inheritState(state);
+		++w.scratch.step;
+		applyAction(run.ctx, w.scratch, (ACTION)a);
+		potential[a] = qualityPotential(run.ctx, run.oracle, w.scratch, run.params.max_steps);
+		moves[n++] = (ACTION)a;
+	}
+	std::sort(moves, moves + n, [&weights, &potential](ACTION a, ACTION b) {
+		if (weights[a] != weights[b]) {
+			return weights[a] > weights[b];
+		}
+		return potential[a] > potential[b];
+	});
+	return n;
+}
+
+// Plays 'a' from the state at 'depth' into the one below. False if it can't execute or leaves
+// progress out of reach
+static bool stepInto(LdsWorker& w, int depth, ACTION a) {
+	const LdsRun& run = w.run;
+	const GameState& state = w.states[depth];
+	if (!canExecuteAction(run.ctx, state, a)) {
+		return false;
+	}
+	GameState& next = w.states[depth + 1];
+	next.inheritState(state);
+	++next.step;
+	applyAction(run.ctx, next, a);
+	return next.progress >= run.ctx.target_progress || canStillFinish(run.oracle, next, run.params.max_steps - next.step);
+}
+
+static void finishLine(LdsWorker& w, int depth) {
+	const GameState& state = w.states[depth];
+	w.run.lines.fetch_add(1, std::memory_order_relaxed);
+	if (state.progress < w.run.ctx.target_progress) {
+		return;
+	}
+	raiseIncumbent(*w.run.incumbent, state.quality);
+	long double score = monteCarloScore(w.run.ctx, state);
+	if (score > w.best.score) {
+		w.best.score = score;
+		w.best.len = depth;
+		memcpy(w.best.actions, w.path, depth * sizeof(ACTION));
+	}
+}
+
+// True if the state at 'depth' is dominated or can't beat the incumbent, and records it otherwise
+static bool prune(LdsWorker& w, int depth, int discrepancies) {
+	const LdsRun& run = w.run;
+	const GameState& state = w.states[depth];
+	if (belowIncumbent(run.ctx, state, run.params.max_steps - state.step, run.incumbent)) {
+		return true;
+	}
+	if (w.seen.size() >= LDS_MAX_SEEN) {
+		w.seen.clear();
+	}
+	LdsFront& front = w.seen[keyOf(state)];
+	for (int i = 0; i < front.n; ++i) {
+		if (front.visits[i].quality >= state.quality && front.visits[i].discrepancies >= discrepancies) {
+			return true;
+		}
+	}
+	// Visits this one dominates add nothing anymore
+	int n = 0;
+	for (int i = 0; i < front.n; ++i) {
+		if (front.visits[i].quality > state.quality || front.visits[i].discrepancies > discrepancies) {
+			front.visits[n++] = front.visits[i];
+		}
+	}
+	front.n = n;
+	if (front.n < LDS_SEEN_PER_KEY) {
+		front.visits[front.n++] = LdsSeen{ .quality = state.quality, .discrepancies = discrepancies };
+	}
+	return false;
+}
+
+static bool isOver(const LdsRun& run, const GameState& state) {
+	return state.progress >= run.ctx.target_progress || state.durability <= 0
+		|| state.step >= run.params.max_steps || state.step - run.start.step >= LDS_MAX_STEPS;
+}
+
+// Follows the greedy move from the state at 'depth', and up to 'width' others for a discrepancy each
+static void search(LdsWorker& w, int depth, int discrepancies) {
+	if ((++w.n_nodes & 255) == 0 && searchLimitsReached(w.run.params.limits)) {
+		w.stopped = true;
+	}
+	if (w.stopped) {
+		return;
+	}
+	if (isOver(w.run, w.states[depth])) {
+		finishLine(w, depth);
+		return;
+	}
+	if (depth > 0 && prune(w, depth, discrepancies)) {
+		return;
+	}
+	ACTION moves[ACTION_COUNT];
+	int n = rankMoves(w, depth, moves);
+	int rank = 0;
+	for (int i = 0; i < n && rank <= w.run.params.width; ++i) {
+		// Each rank past the first spends a discrepancy, moves that can't be played don't count
+		if (rank > 0 && discrepancies == 0) {
+			break;
+		}
+		if (!stepInto(w, depth, moves[i])) {
+			continue;
+		}
+		w.path[depth] = moves[i];
+		search(w, depth + 1, discrepancies - (rank > 0 ? 1 : 0));
+		++rank;
+	}
+	// Nothing the heuristic allows is playable, the line ends here
+	if (rank == 0) {
+		finishLine(w, depth);
+	}
+}
+
+// The greedy line from the start, as the moves and states search() would take without discrepancies
+static int greedyLine(LdsWorker& w, ACTION* line) {
+	int depth = 0;
+	while (!isOver(w.run, w.states[depth])) {
+		ACTION moves[ACTION_COUNT];
+		int n = rankMoves(w, depth, moves);
+		int i = 0;
+		while (i < n && !stepInto(w, depth, moves[i])) {
+			++i;
+		}
+		if (i == n) {
+			break;
+		}
+		line[depth++] = moves[i];
+	}
+	return depth;
+}
+
+// Every line of the pass whose first discrepancy is at 'position' of the greedy line
+static void searchFrom(LdsWorker& w, const ACTION* greedy, int position, int discrepancies) {
+	w.states[0].inheritState(w.run.start);
+	for (int d = 0; d < position; ++d) {
+		stepInto(w, d, greedy[d]);
+		w.path[d] = greedy[d];
+	}
+	ACTION moves[ACTION_COUNT];
+	int n = rankMoves(w, position, moves);
+	int rank = 0;
+	for (int i = 0; i < n && rank <= w.run.params.width && !w.stopped; ++i) {
+		if (!stepInto(w, position, moves[i])) {
+			continue;
+		}
+		// The greedy move itself is the line of every other position
+		if (rank++ == 0) {
+			continue;
+		}
+		w.path[position] = moves[i];
+		search(w, position + 1, discrepancies - 1);
+	}
+}
+
+LdsResult solveByLds(const GameContext& ctx, const ProgressOracle& oracle, const GameState& start, const LdsParams& params) {
+	LdsParams clamped = params;
+	clamped.max_steps = std::min(params.max_steps, start.step + LDS_MAX_STEPS);
+	std::atomic<int> own_incumbent{ -1 };
+	LdsRun run = { .ctx = ctx, .oracle = oracle, .start = start, .params = clamped, .incumbent = params.limits.incumbent ? params.limits.incumbent : &own_incumbent };
+
+	const int n_threads = std::max(1, params.n_threads);
+	std::vector<std::unique_ptr<LdsWorker>> workers;
+	for (int t = 0; t < n_threads; ++t) {
+		workers.emplace_back(new LdsWorker(run));
+	}
+
+	LdsResult result;
+	ACTION greedy[LDS_MAX_STEPS];
+	workers[0]->states[0].inheritState(start);
+	int greedy_len = greedyLine(*workers[0], greedy);
+	memcpy(workers[0]->path, greedy, greedy_len * sizeof(ACTION));
+	finishLine(*workers[0], greedy_len);
+	result.passes = 1;
+
+	for (int k = 1; k <= params.max_discrepancies && !searchLimitsReached(run.params.limits); ++k) {
+		std::atomic<int> next_position{ 0 };
+		auto work = [&next_position, greedy, greedy_len, k](LdsWorker& w) {
+			for (int p = next_position++; p < greedy_len && !w.stopped; p = next_position++) {
+				searchFrom(w, greedy, p, k);
+			}
+		};
+		if (n_threads == 1) {
+			work(*workers[0]);
+		} else {
+			std::vector<std::thread> threads;
+			for (int t = 0; t < n_threads; ++t) {
+				threads.emplace_back(work, std::ref(*workers[t]));
+			}
+			for (std::thread& t : threads) {
+				t.join();
+			}
+		}
+		if (std::any_of(workers.begin(), workers.end(), [](const std::unique_ptr<LdsWorker>& w) { return w->stopped; })) {
+			break;
+		}
+		++result.passes;
+	}
+
+	const LdsLine* best = &workers[0]->best;
+	for (const std::unique_ptr<LdsWorker>& w : workers) {
+		if (w->best.score > best->score) {
+			best = &w->best;
+		}
+	}
+	result.found = best->score >= .0L;
+	result.actions.assign(best->actions, best->actions + best->len);
+	result.lines = run.lines.load();
+	return result;
+}
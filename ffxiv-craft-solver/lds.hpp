@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include "game_config.hpp"
+#include "game_state.hpp"
+#include "progress_oracle.hpp"
+#include "search_limits.hpp"
+
+
+// Limited discrepancy search over the expansion heuristic (assignActionWeights). Moves are ranked
+// by their weight, and the greedy line always takes the best one that keeps the craft finishable
+// by the oracle. Taking the next best instead at some step is a discrepancy. Pass k explores every
+// line with at most k of them, up to 'width' moves deep into the ranking each time, so the greedy
+// line comes first and lines further from it later. Moves the heuristic weighs zero are never tried.
+// A state is skipped if one with the same everything but quality was already searched with as
+// many discrepancies left and at least as much quality, and so is one whose quality ceiling can't
+// beat the best craft so far. Each pass is split by where its first discrepancy falls, and the
+// positions are shared out over n_threads
+struct LdsParams {
+	int max_discrepancies = 3;
+	int width = 3;			// Moves past the greedy one tried at each discrepancy
+	int max_steps = 26;
+	int n_threads = 1;
+	// Early stop, the best line so far is returned. A private incumbent is used without a shared one
+	SearchLimits limits;
+};
+
+struct LdsResult {
+	bool found = false;		// The best line reaches target_progress
+	std::vector<ACTION> actions;
+	int lines = 0;			// Lines followed to their end
+	int passes = 0;			// Discrepancy limits fully searched
+};
+
+// Searches from 'start' with an oracle built for ctx
+LdsResult solveByLds(const GameContext& ctx, const ProgressOracle& oracle, const GameState& start, const LdsParams& params);
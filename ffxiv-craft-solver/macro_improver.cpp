@@ -0,0 +1,91 @@
+#include "macro_improver.hpp"
+
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include "prefix_cache.hpp"
+#include "solver.hpp"
+
+
+// Finished crafts only, invalid ones score below zero
+static double simulate(const GameContext& ctx, PrefixCache& cache, std::vector<ACTION>& macro, int max_steps, GameState& state) {
+	int n = cache.play(macro.data(), (int)macro.size(), max_steps, state);
+	if (state.progress < ctx.target_progress) {
+		return -1.0;
+	}
+	// Anything after the finishing action is dropped
+	macro.resize(n);
+	return std::min(state.quality, ctx.target_quality) + 1e-3 * state.cp + 1e-6 * (max_steps - state.step);
+}
+
+bool improveMacro(const GameContext& ctx, const GameState& start, std::vector<ACTION>& macro, const ImproveParams& params, GameState& end) {
+	// Neighbours share all actions before the one they change
+	PrefixCache cache(ctx, start);
+	GameState state{};
+	std::vector<ACTION> current = macro;
+	double current_score = simulate(ctx, cache, current, params.max_steps, state);
+	if (current_score < .0 || current.empty()) {
+		return false;
+	}
+	std::vector<ACTION> best = current;
+	double best_score = current_score;
+	double initial_score = current_score;
+
+	std::mt19937 rng{ std::random_device{}() };
+	std::uniform_int_distribution<int> any_action(0, ACTION_COUNT - 1);
+	std::uniform_real_distribution<double> chance(.0, 1.);
+	const double t0 = params.start_temperature * ctx.target_quality;
+	const auto begin = std::chrono::steady_clock::now();
+	std::vector<ACTION> candidate;
+	double temperature = t0;
+	for (int iteration = 0;; ++iteration) {
+		// Cooling follows elapsed time, checked every few neighbours
+		if (iteration % 32 == 0) {
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
+			if (elapsed.count() >= params.time_budget_ms) {
+				break;
+			}
+			temperature = t0 * (1.0 - elapsed.count() / params.time_budget_ms);
+		}
+
+		candidate = current;
+		int n = (int)candidate.size();
+		std::uniform_int_distribution<int> at(0, n - 1);
+		switch (std::uniform_int_distribution<int>(0, 3)(rng)) {
+		case 0:
+			std::swap(candidate[at(rng)], candidate[at(rng)]);
+			break;
+		case 1:
+			candidate.insert(candidate.begin() + std::uniform_int_distribution<int>(0, n)(rng), (ACTION)any_action(rng));
+			break;
+		case 2:
+			if (n > 1) {
+				candidate.erase(candidate.begin() + at(rng));
+			}
+			break;
+		default:
+			candidate[at(rng)] = (ACTION)any_action(rng);
+			break;
+		}
+		double score = simulate(ctx, cache, candidate, params.max_steps, state);
+		if (score < .0) {
+			continue;
+		}
+		if (score >= current_score || (temperature > .0 && chance(rng) < exp((score - current_score) / temperature))) {
+			current.swap(candidate);
+			current_score = score;
+			if (score > best_score) {
+				best = current;
+				best_score = score;
+			}
+		}
+	}
+
+	if (best_score <= initial_score) {
+		return false;
+	}
+	simulate(ctx, cache, best, params.max_steps, end);
+	macro = best;
+	return true;
+}
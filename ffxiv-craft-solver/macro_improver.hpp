@@ -0,0 +1,19 @@
+#pragma once
+
+#include <vector>
+#include "game_config.hpp"
+#include "game_state.hpp"
+
+
+// Simulated annealing over a finished macro. Neighbours swap two actions, insert, delete or
+// replace one, and are scored by re-simulating from the start on a plain GameState. A neighbour
+// has to finish the craft within max_steps, anything left after it finishes is dropped.
+// Quality up to target_quality counts first, then CP left, then fewer steps
+struct ImproveParams {
+	int max_steps = 26;
+	int time_budget_ms = 20;
+	float start_temperature = .01f;	// Fraction of target_quality
+};
+
+// Replaces 'macro' and fills 'end' with where it finishes if a better macro was found
+bool improveMacro(const GameContext& ctx, const GameState& start, std::vector<ACTION>& macro, const ImproveParams& params, GameState& end);
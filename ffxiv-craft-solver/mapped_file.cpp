@@ -0,0 +1,168 @@
+#include "mapped_file.hpp"
+
+#include <stdint.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+#ifdef _WIN32
+
+bool mapFileRead(const char* path, MappedFile& out) {
+	out = MappedFile();
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+	if (!mapping) {
+		CloseHandle(file);
+		return false;
+	}
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	out.data = data;
+	out.size = (size_t)size.QuadPart;
+	out.file_handle = file;
+	out.mapping_handle = mapping;
+	return true;
+}
+
+bool mapFileReadWrite(const char* path, size_t size, MappedFile& out) {
+	out = MappedFile();
+	HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)(size & 0xFFFFFFFF), 0);
+	if (!mapping) {
+		CloseHandle(file);
+		return false;
+	}
+	void* data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	if (!data) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	out.data = data;
+	out.size = size;
+	out.file_handle = file;
+	out.mapping_handle = mapping;
+	return true;
+}
+
+void unmapFile(MappedFile& file) {
+	if (file.data) {
+		UnmapViewOfFile(file.data);
+	}
+	if (file.mapping_handle) {
+		CloseHandle((HANDLE)file.mapping_handle);
+	}
+	if (file.file_handle) {
+		CloseHandle((HANDLE)file.file_handle);
+	}
+	file = MappedFile();
+}
+
+void adviseMappedRange(MappedFile& file, size_t offset, size_t size, MAPPED_ACCESS access) {
+	if (access == MA_WILLNEED) {
+		WIN32_MEMORY_RANGE_ENTRY range = { (char*)file.data + offset, size };
+		PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+	} else if (access == MA_DONTNEED) {
+		VirtualUnlock((char*)file.data + offset, size);
+	}
+}
+
+#else
+
+bool mapFileRead(const char* path, MappedFile& out) {
+	out = MappedFile();
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		return false;
+	}
+	void* data = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (data == MAP_FAILED) {
+		close(fd);
+		return false;
+	}
+	out.data = data;
+	out.size = (size_t)st.st_size;
+	out.fd = fd;
+	return true;
+}
+
+bool mapFileReadWrite(const char* path, size_t size, MappedFile& out) {
+	out = MappedFile();
+	int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		return false;
+	}
+	if (ftruncate(fd, (off_t)size) != 0) {
+		close(fd);
+		return false;
+	}
+	void* data = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (data == MAP_FAILED) {
+		close(fd);
+		return false;
+	}
+	out.data = data;
+	out.size = size;
+	out.fd = fd;
+	return true;
+}
+
+void unmapFile(MappedFile& file) {
+	if (file.data) {
+		munmap(file.data, file.size);
+	}
+	if (file.fd >= 0) {
+		close(file.fd);
+	}
+	file = MappedFile();
+}
+
+void adviseMappedRange(MappedFile& file, size_t offset, size_t size, MAPPED_ACCESS access) {
+	// madvise wants a page aligned start
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	size_t begin = offset & ~(page - 1);
+	size += offset - begin;
+	int advice = MADV_NORMAL;
+	switch (access) {
+	case MA_NORMAL: advice = MADV_NORMAL; break;
+	case MA_RANDOM: advice = MADV_RANDOM; break;
+	case MA_WILLNEED: advice = MADV_WILLNEED; break;
+	case MA_DONTNEED: advice = MADV_DONTNEED; break;
+	}
+	madvise((char*)file.data + begin, size, advice);
+}
+
+#endif
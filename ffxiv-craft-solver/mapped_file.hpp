@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+
+
+struct MappedFile {
+	void* data = 0;
+	size_t size = 0;
+
+	// Platform handles, kept opaque so windows.h doesn't leak into every includer
+	void* file_handle = 0;
+	void* mapping_handle = 0;
+	int fd = -1;
+};
+
+enum MAPPED_ACCESS {
+	MA_NORMAL,
+	MA_RANDOM,		// Disables readahead, for scattered node access
+	MA_WILLNEED,	// Start paging the range in
+	MA_DONTNEED		// Range is cold, let the OS drop it first
+};
+
+bool mapFileRead(const char* path, MappedFile& out);
+// Creates (or truncates) the file to 'size' bytes and maps it shared, read-write
+bool mapFileReadWrite(const char* path, size_t size, MappedFile& out);
+void unmapFile(MappedFile& file);
+
+// Best-effort hint, silently ignored where the platform has no equivalent
+void adviseMappedRange(MappedFile& file, size_t offset, size_t size, MAPPED_ACCESS access);
@@ -0,0 +1,161 @@
+#include "metrics.hpp"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "game_state_handle.hpp"
+
+
+thread_local int64_t metrics_depth_visits[METRICS_MAX_DEPTH];
+thread_local int64_t metrics_depth_nodes[METRICS_MAX_DEPTH];
+thread_local int64_t metrics_nodes_created = 0;
+
+struct BestScoreSample {
+	double elapsed_sec;
+	double score;
+	int quality;
+	int progress;
+};
+
+// Improvements come in bursts early on, after this many samples only the latest is updated
+constexpr int MAX_BEST_HISTORY = 4096;
+
+static thread_local std::chrono::steady_clock::time_point start_time;
+static thread_local std::vector<BestScoreSample> best_history;
+
+// Previous publish, for rates
+static thread_local double prev_elapsed = .0;
+static thread_local int64_t prev_playouts = 0;
+static thread_local int64_t prev_nodes = 0;
+
+static double elapsedSec() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+void metricsReset() {
+	std::fill(metrics_depth_visits, metrics_depth_visits + METRICS_MAX_DEPTH, 0);
+	std::fill(metrics_depth_nodes, metrics_depth_nodes + METRICS_MAX_DEPTH, 0);
+	metrics_nodes_created = 0;
+	best_history.clear();
+	start_time = std::chrono::steady_clock::now();
+	prev_elapsed = .0;
+	prev_playouts = 0;
+	prev_nodes = 0;
+}
+
+void metricsRecordBest(double score, int quality, int progress) {
+	BestScoreSample sample = { elapsedSec(), score, quality, progress };
+	if (best_history.size() < MAX_BEST_HISTORY) {
+		best_history.push_back(sample);
+	} else {
+		best_history.back() = sample;
+	}
+}
+
+// Both files are written next to their final name and renamed into place,
+// so a poller never sees a half-written snapshot
+static bool writeAtomically(const std::string& path, const std::string& content) {
+	std::string tmp_path = path + ".tmp";
+	FILE* f = fopen(tmp_path.c_str(), "wb");
+	if (!f) {
+		return false;
+	}
+	bool ok = fwrite(content.data(), 1, content.size(), f) == content.size();
+	ok = (fclose(f) == 0) && ok;
+	if (!ok) {
+		remove(tmp_path.c_str());
+		return false;
+	}
+	std::error_code ec;
+	std::filesystem::rename(tmp_path, path, ec);
+	return !ec;
+}
+
+static void appendf(std::string& out, const char* fmt, ...) {
+	char buf[512];
+	va_list args;
+	va_start(args, fmt);
+	int n = vsnprintf(buf, sizeof(buf), fmt, args);
+	va_end(args);
+	if (n > 0) {
+		out.append(buf, std::min(n, (int)sizeof(buf) - 1));
+	}
+}
+
+bool metricsPublish(const char* path, const MetricsSearchState& search) {
+	double elapsed = elapsedSec();
+	int64_t nodes = metrics_nodes_created;
+	int max_depth = 0;
+	for (int i = 0; i < METRICS_MAX_DEPTH; ++i) {
+		if (metrics_depth_nodes[i] || metrics_depth_visits[i]) {
+			max_depth = i + 1;
+		}
+	}
+
+	double dt = elapsed - prev_elapsed;
+	double playouts_per_sec = dt > .0 ? (search.playouts - prev_playouts) / dt : .0;
+	double nodes_per_sec = dt > .0 ? (nodes - prev_nodes) / dt : .0;
+	prev_elapsed = elapsed;
+	prev_playouts = search.playouts;
+	prev_nodes = nodes;
+
+	int capacity = getGameStatePoolCapacity();
+	int occupancy = getAllocatedStatesCount();
+	int high_water = getGameStatePoolHighWater();
+	int free_list = getFreeSlotCount();
+
+	std::string json;
+	appendf(json, "{\n\t\"elapsed_sec\": %.3f,\n\t\"iteration\": %i,\n\t\"n_iterations\": %i,\n", elapsed, search.iteration, search.n_iterations);
+	appendf(json, "\t\"playouts\": %lld,\n\t\"playouts_per_sec\": %.1f,\n\t\"nodes\": %lld,\n\t\"nodes_per_sec\": %.1f,\n",
+		(long long)search.playouts, playouts_per_sec, (long long)nodes, nodes_per_sec);
+	appendf(json, "\t\"pool\": { \"capacity\": %i, \"occupancy\": %i, \"high_water\": %i, \"free_list\": %i },\n",
+		capacity, occupancy, high_water, free_list);
+	appendf(json, "\t\"deleted_states\": %i,\n\t\"best_score\": %.6f,\n", search.n_deleted_states, search.best_score);
+	json += "\t\"depth\": [";
+	for (int i = 0; i < max_depth; ++i) {
+		// Branching = nodes one level down per node at this level
+		double branching = metrics_depth_nodes[i] && i + 1 < METRICS_MAX_DEPTH
+			? metrics_depth_nodes[i + 1] / (double)metrics_depth_nodes[i] : .0;
+		appendf(json, "%s\n\t\t{ \"depth\": %i, \"visits\": %lld, \"nodes\": %lld, \"branching\": %.3f }",
+			i ? "," : "", i, (long long)metrics_depth_visits[i], (long long)metrics_depth_nodes[i], branching);
+	}
+	json += "\n\t],\n\t\"best_history\": [";
+	for (size_t i = 0; i < best_history.size(); ++i) {
+		const BestScoreSample& s = best_history[i];
+		appendf(json, "%s\n\t\t{ \"elapsed_sec\": %.3f, \"score\": %.6f, \"quality\": %i, \"progress\": %i }",
+			i ? "," : "", s.elapsed_sec, s.score, s.quality, s.progress);
+	}
+	json += "\n\t]\n}\n";
+
+	std::string prom;
+	appendf(prom, "# TYPE solver_iteration gauge\nsolver_iteration %i\n", search.iteration);
+	appendf(prom, "# TYPE solver_playouts_total counter\nsolver_playouts_total %lld\n", (long long)search.playouts);
+	appendf(prom, "# TYPE solver_playouts_per_second gauge\nsolver_playouts_per_second %.1f\n", playouts_per_sec);
+	appendf(prom, "# TYPE solver_nodes_total counter\nsolver_nodes_total %lld\n", (long long)nodes);
+	appendf(prom, "# TYPE solver_nodes_per_second gauge\nsolver_nodes_per_second %.1f\n", nodes_per_sec);
+	appendf(prom, "# TYPE solver_pool_capacity gauge\nsolver_pool_capacity %i\n", capacity);
+	appendf(prom, "# TYPE solver_pool_occupancy gauge\nsolver_pool_occupancy %i\n", occupancy);
+	appendf(prom, "# TYPE solver_pool_high_water gauge\nsolver_pool_high_water %i\n", high_water);
+	appendf(prom, "# TYPE solver_pool_free_list gauge\nsolver_pool_free_list %i\n", free_list);
+	appendf(prom, "# TYPE solver_deleted_states_total counter\nsolver_deleted_states_total %i\n", search.n_deleted_states);
+	appendf(prom, "# TYPE solver_best_score gauge\nsolver_best_score %.6f\n", search.best_score);
+	if (!best_history.empty()) {
+		appendf(prom, "# TYPE solver_best_quality gauge\nsolver_best_quality %i\n", best_history.back().quality);
+	}
+	prom += "# TYPE solver_depth_visits_total counter\n";
+	for (int i = 0; i < max_depth; ++i) {
+		appendf(prom, "solver_depth_visits_total{depth=\"%i\"} %lld\n", i, (long long)metrics_depth_visits[i]);
+	}
+	prom += "# TYPE solver_depth_nodes gauge\n";
+	for (int i = 0; i < max_depth; ++i) {
+		appendf(prom, "solver_depth_nodes{depth=\"%i\"} %lld\n", i, (long long)metrics_depth_nodes[i]);
+	}
+
+	bool ok = writeAtomically(path, json);
+	ok = writeAtomically(std::string(path) + ".prom", prom) && ok;
+	return ok;
+}
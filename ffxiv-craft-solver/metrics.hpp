@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+
+
+// Solver health snapshot for external monitoring. The search loop feeds the
+// histograms through the record functions; metricsPublish() fills in the rest
+// and writes 'path' (JSON) and 'path'.prom (Prometheus text format)
+
+constexpr int METRICS_MAX_DEPTH = 64;
+
+// Per thread, like the rest of the search state
+extern thread_local int64_t metrics_depth_visits[METRICS_MAX_DEPTH];
+extern thread_local int64_t metrics_depth_nodes[METRICS_MAX_DEPTH];	// Live tree nodes
+extern thread_local int64_t metrics_nodes_created;
+
+void metricsReset();
+
+// Hot path, just histogram bumps
+inline void metricsRecordSelect(int depth) {
+	++metrics_depth_visits[depth < METRICS_MAX_DEPTH ? depth : METRICS_MAX_DEPTH - 1];
+}
+// For nodes already in the tree when a search starts, resumed or seeded
+inline void metricsRecordLiveNode(int depth) {
+	++metrics_depth_nodes[depth < METRICS_MAX_DEPTH ? depth : METRICS_MAX_DEPTH - 1];
+}
+inline void metricsRecordNode(int depth) {
+	metricsRecordLiveNode(depth);
+	++metrics_nodes_created;
+}
+inline void metricsForgetNode(int depth) {
+	--metrics_depth_nodes[depth < METRICS_MAX_DEPTH ? depth : METRICS_MAX_DEPTH - 1];
+}
+void metricsRecordBest(double score, int quality, int progress);
+
+struct MetricsSearchState {
+	int iteration;
+	int n_iterations;
+	int64_t playouts;
+	int n_deleted_states;
+	double best_score;
+};
+
+bool metricsPublish(const char* path, const MetricsSearchState& search);
@@ -0,0 +1,192 @@
+#include "nrpa.hpp"
+
+#include <math.h>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <thread>
+#include "actions.hpp"
+#include "portfolio.hpp"
+#include "prefix_cache.hpp"
+#include "solver.hpp"
+
+
+constexpr int NRPA_MAX_STEPS = 64;
+constexpr int POLICY_SIZE = (ACTION_COUNT + 1) * 2 * 3 * ACTION_COUNT;
+
+struct NrpaSequence {
+	float score = -1.f;
+	int len = 0;
+	uint8_t actions[NRPA_MAX_STEPS];
+};
+
+typedef std::vector<float> NrpaPolicy;
+
+struct NrpaRun {
+	const GameContext& ctx;
+	const ProgressOracle& oracle;
+	const GameState& start;
+	const NrpaParams& params;
+	std::atomic<int> playouts{ 0 };
+	// One per thread of the parallel level, the first one also serves the levels above
+	std::vector<std::unique_ptr<PrefixCache>> caches;
+};
+
+static int policyCode(const GameState& state, ACTION a) {
+	int prev = state.used_action_idx >= 0 && state.used_action_idx < ACTION_COUNT ? state.used_action_idx + 1 : 0;
+	int innovation = state.effects[E_INNOVATION].n_charges > 0 ? 1 : 0;
+	int inner_quiet = state.effects[E_INNER_QUIET].n_stacks >= 10 ? 2 : (state.effects[E_INNER_QUIET].n_stacks >= 5 ? 1 : 0);
+	return (((prev * 2) + innovation) * 3 + inner_quiet) * ACTION_COUNT + a;
+}
+
+// Finished crafts score above 1 by capped quality, unfinished ones below by progress
+static float sequenceScore(const GameContext& ctx, const GameState& state) {
+	if (state.progress >= ctx.target_progress) {
+		return 1.f + std::min(1.f, state.quality / (float)ctx.target_quality);
+	}
+	return .5f * state.progress / (float)ctx.target_progress;
+}
+
+static bool isOver(const NrpaRun& run, const GameState& state) {
+	return state.progress >= run.ctx.target_progress || state.durability <= 0 || state.step >= run.params.max_steps;
+}
+
+// Moves from 'node' that keep the craft finishable, with the nodes they lead to
+static int legalMoves(PrefixCache& cache, int node, ACTION* moves, int* next) {
+	int n = 0;
+	for (int a = 0; a < ACTION_COUNT; ++a) {
+		int c = cache.child(node, (ACTION)a);
+		if (c < 0) {
+			continue;
+		}
+		moves[n] = (ACTION)a;
+		next[n++] = c;
+	}
+	return n;
+}
+
+static void playout(NrpaRun& run, PrefixCache& cache, const NrpaPolicy& policy, std::mt19937& rng, NrpaSequence& seq) {
+	GameState state{};
+	int node = cache.begin();
+	cache.load(node, state);
+	int next[ACTION_COUNT];
+	ACTION moves[ACTION_COUNT];
+	float weights[ACTION_COUNT];
+	seq.len = 0;
+	while (!isOver(run, state) && seq.len < NRPA_MAX_STEPS) {
+		int n = legalMoves(cache, node, moves, next);
+		if (n == 0) {
+			break;
+		}
+		float z = .0f;
+		for (int i = 0; i < n; ++i) {
+			weights[i] = expf(policy[policyCode(state, moves[i])]);
+			z += weights[i];
+		}
+		float r = std::uniform_real_distribution<float>(.0f, z)(rng);
+		int pick = n - 1;
+		for (int i = 0; i < n - 1; ++i) {
+			r -= weights[i];
+			if (r < .0f) {
+				pick = i;
+				break;
+			}
+		}
+		seq.actions[seq.len++] = (uint8_t)moves[pick];
+		node = next[pick];
+		cache.load(node, state);
+	}
+	seq.score = sequenceScore(run.ctx, state);
+	if (run.params.limits.incumbent && state.progress >= run.ctx.target_progress) {
+		raiseIncumbent(*run.params.limits.incumbent, state.quality);
+	}
+	run.playouts.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Shifts 'policy' towards 'seq', normalized over the moves each step had
+static void adapt(const NrpaRun& run, PrefixCache& cache, NrpaPolicy& policy, const NrpaSequence& seq) {
+	NrpaPolicy old = policy;
+	GameState state{};
+	int node = cache.begin();
+	cache.load(node, state);
+	int next[ACTION_COUNT];
+	ACTION moves[ACTION_COUNT];
+	for (int i = 0; i < seq.len; ++i) {
+		int n = legalMoves(cache, node, moves, next);
+		float z = .0f;
+		for (int m = 0; m < n; ++m) {
+			z += expf(old[policyCode(state, moves[m])]);
+		}
+		int played = -1;
+		for (int m = 0; m < n; ++m) {
+			policy[policyCode(state, moves[m])] -= run.params.alpha * expf(old[policyCode(state, moves[m])]) / z;
+			if (moves[m] == seq.actions[i]) {
+				played = m;
+			}
+		}
+		if (played < 0) {
+			break;
+		}
+		policy[policyCode(state, moves[played])] += run.params.alpha;
+		node = next[played];
+		cache.load(node, state);
+	}
+}
+
+static void nestedSearch(NrpaRun& run, PrefixCache& cache, int level, NrpaPolicy policy, std::mt19937& rng, NrpaSequence& best) {
+	best.score = -1.f;
+	if (level == 0) {
+		playout(run, cache, policy, rng, best);
+		return;
+	}
+	const int n_threads = level == 2 ? std::max(1, run.params.n_threads) : 1;
+	std::vector<NrpaSequence> found(n_threads);
+	for (int i = 0; i < run.params.iterations && !searchLimitsReached(run.params.limits); i += n_threads) {
+		int n = std::min(n_threads, run.params.iterations - i);
+		if (n == 1) {
+			nestedSearch(run, cache, level - 1, policy, rng, found[0]);
+		} else {
+			std::vector<std::thread> threads;
+			std::vector<uint32_t> seeds(n);
+			for (uint32_t& s : seeds) {
+				s = rng();
+			}
+			for (int t = 0; t < n; ++t) {
+				threads.emplace_back([&run, level, &policy, &found, &seeds, t]() {
+					std::mt19937 thread_rng(seeds[t]);
+					nestedSearch(run, *run.caches[t], level - 1, policy, thread_rng, found[t]);
+				});
+			}
+			for (std::thread& t : threads) {
+				t.join();
+			}
+		}
+		for (int t = 0; t < n; ++t) {
+			if (found[t].score >= best.score) {
+				best = found[t];
+			}
+			adapt(run, cache, policy, best);
+		}
+	}
+}
+
+NrpaResult solveByNrpa(const GameContext& ctx, const ProgressOracle& oracle, const GameState& start, const NrpaParams& params) {
+	NrpaParams clamped = params;
+	clamped.max_steps = std::min(params.max_steps, start.step + NRPA_MAX_STEPS);
+	NrpaRun run = { .ctx = ctx, .oracle = oracle, .start = start, .params = clamped };
+	for (int t = 0; t < std::max(1, params.n_threads); ++t) {
+		run.caches.emplace_back(new PrefixCache(ctx, start, &oracle, clamped.max_steps, params.limits.incumbent));
+	}
+	std::mt19937 rng{ std::random_device{}() };
+	NrpaSequence best;
+	nestedSearch(run, *run.caches[0], std::max(0, params.level), NrpaPolicy(POLICY_SIZE, .0f), rng, best);
+
+	NrpaResult result;
+	result.found = best.score >= 1.f;
+	result.score = best.score;
+	for (int i = 0; i < best.len; ++i) {
+		result.actions.push_back((ACTION)best.actions[i]);
+	}
+	result.playouts = run.playouts.load();
+	return result;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+#include "game_config.hpp"
+#include "game_state.hpp"
+#include "progress_oracle.hpp"
+#include "search_limits.hpp"
+
+
+// Nested Rollout Policy Adaptation. A policy of weights over action features (the previous
+// action, whether Innovation is up and how far Inner Quiet is built) drives softmax playouts
+// of the plain simulator. Level 0
+// is one playout, level n runs 'iterations' searches of level n - 1 and after each one adapts its
+// policy towards the best sequence so far. Sequences are kept as small arrays, nothing is pooled.
+// Moves that leave progress out of reach by the oracle, or quality below the incumbent, are never played
+struct NrpaParams {
+	int level = 3;
+	int iterations = 100;
+	int max_steps = 26;
+	float alpha = 1.f;
+	// The searches of level 1 run this many at a time from the same policy
+	int n_threads = 1;
+	// Early stop, the best sequence so far is returned
+	SearchLimits limits;
+};
+
+struct NrpaResult {
+	bool found = false;		// The best sequence reaches target_progress
+	float score = .0f;
+	std::vector<ACTION> actions;
+	int playouts = 0;
+};
+
+// Searches from 'start' with an oracle built for ctx
+NrpaResult solveByNrpa(const GameContext& ctx, const ProgressOracle& oracle, const GameState& start, const NrpaParams& params);
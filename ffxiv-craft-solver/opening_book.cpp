@@ -0,0 +1,215 @@
+#include "opening_book.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "batch.hpp"
+#include "solver.hpp"
+#include "work_stealing_pool.hpp"
+
+
+constexpr uint32_t OPENING_BOOK_MAGIC = 0x4B424F46; // "FOBK"
+constexpr uint32_t OPENING_BOOK_VERSION = 1;
+
+struct OpeningBookHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t class_size;
+	uint32_t line_size;
+	uint32_t n_classes;
+	uint32_t n_lines;
+};
+
+static bool operator<(const OpeningClass& a, const OpeningClass& b) {
+	return memcmp(&a, &b, sizeof(OpeningClass)) < 0;
+}
+
+static uint16_t roundedRatio(int num, int den, int step) {
+	if (den <= 0) {
+		return 0;
+	}
+	return (uint16_t)std::min(65535, (num + den * step / 2) / (den * step));
+}
+
+OpeningClass openingClassOf(const GameContext& ctx) {
+	OpeningClass cls;
+	memset(&cls, 0, sizeof(cls));
+	cls.durability = (uint16_t)ctx.max_durability;
+	cls.progress_steps = roundedRatio(ctx.target_progress, ctx.base_progress_increase, 1);
+	cls.quality_steps = roundedRatio(ctx.target_quality, ctx.base_quality_increase, 4);
+	cls.cp_bucket = (uint16_t)(ctx.max_cp / 100);
+	return cls;
+}
+
+bool openOpeningBook(const char* path, OpeningBook& book) {
+	book = OpeningBook();
+	if (!mapFileRead(path, book.file)) {
+		return false;
+	}
+	const OpeningBookHeader* header = (const OpeningBookHeader*)book.file.data;
+	if (book.file.size < sizeof(OpeningBookHeader)
+		|| header->magic != OPENING_BOOK_MAGIC
+		|| header->version != OPENING_BOOK_VERSION
+		|| header->class_size != sizeof(OpeningClassRecord)
+		|| header->line_size != sizeof(OpeningLine)
+		|| book.file.size < sizeof(OpeningBookHeader) + (size_t)header->n_classes * sizeof(OpeningClassRecord) + (size_t)header->n_lines * sizeof(OpeningLine)
+	) {
+		unmapFile(book.file);
+		return false;
+	}
+	book.classes = (const OpeningClassRecord*)(header + 1);
+	book.lines = (const OpeningLine*)(book.classes + header->n_classes);
+	book.n_classes = header->n_classes;
+	book.n_lines = header->n_lines;
+	for (int i = 0; i < book.n_classes; ++i) {
+		if ((uint64_t)book.classes[i].first_line + book.classes[i].n_lines > (uint64_t)book.n_lines) {
+			closeOpeningBook(book);
+			return false;
+		}
+	}
+	// Lines are played as they are, so they have to hold real actions
+	for (int i = 0; i < book.n_lines; ++i) {
+		const OpeningLine& line = book.lines[i];
+		bool ok = line.len <= OPENING_MAX_LEN;
+		for (uint32_t j = 0; ok && j < line.len; ++j) {
+			ok = line.actions[j] < ACTION_COUNT;
+		}
+		if (!ok) {
+			closeOpeningBook(book);
+			return false;
+		}
+	}
+	return true;
+}
+
+void closeOpeningBook(OpeningBook& book) {
+	unmapFile(book.file);
+	book = OpeningBook();
+}
+
+const OpeningLine* findOpenings(const OpeningBook& book, const GameContext& ctx, int& n) {
+	n = 0;
+	OpeningClass cls = openingClassOf(ctx);
+	const OpeningClassRecord* end = book.classes + book.n_classes;
+	const OpeningClassRecord* it = std::lower_bound(book.classes, end, cls, [](const OpeningClassRecord& r, const OpeningClass& cls)->bool {
+		return r.cls < cls;
+	});
+	if (it == end || memcmp(&it->cls, &cls, sizeof(cls))) {
+		return 0;
+	}
+	n = it->n_lines;
+	return book.lines + it->first_line;
+}
+
+struct OpeningTally {
+	uint32_t n_samples = 0;
+	uint32_t n_finished = 0;
+	double sum_quality = 0;
+	float best_quality = 0;
+};
+
+static float rankOf(const OpeningLine& line) {
+	return line.mean_quality * line.n_finished / (float)line.n_samples;
+}
+
+bool buildOpeningBook(const char* jobs_path, const char* book_path, int depth, int samples, int n_threads, int pool_size) {
+	depth = std::clamp(depth, 1, OPENING_MAX_LEN);
+	std::vector<BatchJob> jobs;
+	if (!readBatchJobs(jobs_path, jobs)) {
+		printf("Failed to read opening book jobs from %s\n", jobs_path);
+		return false;
+	}
+
+	std::mutex tally_mutex;
+	std::map<OpeningClass, std::map<std::vector<ACTION>, OpeningTally>> tallies;
+	std::vector<std::unique_ptr<Solver>> solvers(std::max(1, n_threads));
+	SolveParams params;
+	{
+		WorkStealingPool pool((int)solvers.size(), [&solvers, pool_size](int worker) { solvers[worker] = std::make_unique<Solver>(pool_size); });
+		for (const BatchJob& job : jobs) {
+			for (int s = 0; s < samples; ++s) {
+				pool.submit([&job, &solvers, &params, &tallies, &tally_mutex, depth](int worker) {
+					SolveResult r = solvers[worker]->solve(job.ctx, params);
+					if ((int)r.actions.size() <= depth) {
+						return;
+					}
+					std::vector<ACTION> opening(r.actions.begin(), r.actions.begin() + depth);
+					float quality = job.ctx.target_quality > 0 ? std::min(1.0f, r.quality / (float)job.ctx.target_quality) : 1.0f;
+
+					std::lock_guard<std::mutex> lock(tally_mutex);
+					OpeningTally& t = tallies[openingClassOf(job.ctx)][opening];
+					++t.n_samples;
+					if (r.found) {
+						++t.n_finished;
+						t.sum_quality += quality;
+						t.best_quality = std::max(t.best_quality, quality);
+					}
+				});
+			}
+		}
+		pool.wait();
+	}
+	if (break_requested) {
+		return false;
+	}
+
+	std::vector<OpeningClassRecord> classes;
+	std::vector<OpeningLine> lines;
+	for (auto& [cls, openings] : tallies) {
+		std::vector<OpeningLine> ranked;
+		for (auto& [opening, t] : openings) {
+			OpeningLine line;
+			memset(&line, 0, sizeof(line));
+			for (int i = 0; i < (int)opening.size(); ++i) {
+				line.actions[i] = (uint8_t)opening[i];
+			}
+			line.len = (uint32_t)opening.size();
+			line.n_samples = t.n_samples;
+			line.n_finished = t.n_finished;
+			line.mean_quality = t.n_finished ? (float)(t.sum_quality / t.n_finished) : .0f;
+			line.best_quality = t.best_quality;
+			if (line.n_finished) {
+				ranked.push_back(line);
+			}
+		}
+		if (ranked.empty()) {
+			continue;
+		}
+		std::stable_sort(ranked.begin(), ranked.end(), [](const OpeningLine& a, const OpeningLine& b)->bool {
+			return rankOf(a) > rankOf(b);
+		});
+		ranked.resize(std::min((int)ranked.size(), OPENING_MAX_LINES));
+		OpeningClassRecord rec;
+		memset(&rec, 0, sizeof(rec));
+		rec.cls = cls;
+		rec.first_line = (uint32_t)lines.size();
+		rec.n_lines = (uint32_t)ranked.size();
+		classes.push_back(rec);
+		lines.insert(lines.end(), ranked.begin(), ranked.end());
+	}
+
+	FILE* out = fopen(book_path, "wb");
+	if (!out) {
+		return false;
+	}
+	OpeningBookHeader header = {
+		.magic = OPENING_BOOK_MAGIC,
+		.version = OPENING_BOOK_VERSION,
+		.class_size = sizeof(OpeningClassRecord),
+		.line_size = sizeof(OpeningLine),
+		.n_classes = (uint32_t)classes.size(),
+		.n_lines = (uint32_t)lines.size()
+	};
+	bool ok = fwrite(&header, sizeof(header), 1, out) == 1
+		&& (classes.empty() || fwrite(classes.data(), sizeof(OpeningClassRecord), classes.size(), out) == classes.size())
+		&& (lines.empty() || fwrite(lines.data(), sizeof(OpeningLine), lines.size(), out) == lines.size());
+	ok = (fclose(out) == 0) && ok;
+	if (ok) {
+		printf("Opening book: %i classes, %i lines from %i solves\n", (int)classes.size(), (int)lines.size(), (int)jobs.size() * samples);
+	}
+	return ok;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+#include "action_enum.hpp"
+#include "game_config.hpp"
+#include "mapped_file.hpp"
+
+
+// Opening book: ranked opening sequences per recipe class, built offline by
+// solving a set of crafts and tallying how their best macros start.
+// Like the recipe database the file is mapped read-only and looked up with a
+// binary search, so it costs nothing to open
+
+constexpr int OPENING_MAX_LEN = 8;
+constexpr int OPENING_MAX_LINES = 4;	// Kept per class
+
+// Crafts that share a class tend to share an opener
+struct OpeningClass {
+	uint16_t durability;
+	uint16_t progress_steps;	// target_progress / base_progress, rounded
+	uint16_t quality_steps;		// target_quality / base_quality, in steps of 4
+	uint16_t cp_bucket;			// max_cp in steps of 100
+};
+
+struct OpeningClassRecord {
+	OpeningClass cls;
+	uint32_t first_line;
+	uint32_t n_lines;
+};
+
+struct OpeningLine {
+	uint8_t actions[OPENING_MAX_LEN];
+	uint32_t len;
+	uint32_t n_samples;		// Solved crafts whose best macro started this way
+	uint32_t n_finished;	// ... and reached target_progress
+	float mean_quality;		// Quality reached as a fraction of target_quality, capped at 1
+	float best_quality;
+};
+
+struct OpeningBook {
+	MappedFile file;
+	const OpeningClassRecord* classes = 0;
+	const OpeningLine* lines = 0;
+	int n_classes = 0;
+	int n_lines = 0;
+};
+
+OpeningClass openingClassOf(const GameContext& ctx);
+
+bool openOpeningBook(const char* path, OpeningBook& book);
+void closeOpeningBook(OpeningBook& book);
+
+// Lines for the class of 'ctx', best first. Returns 0 and n = 0 for an unknown class
+const OpeningLine* findOpenings(const OpeningBook& book, const GameContext& ctx, int& n);
+
+// Solves every job of a batch jobs file (see batch.hpp) 'samples' times and keeps the
+// first 'depth' actions of each best macro, ranked per class by finish rate times mean quality
+bool buildOpeningBook(const char* jobs_path, const char* book_path, int depth, int samples, int n_threads, int pool_size);
@@ -0,0 +1,249 @@
+#include "phase_solver.hpp"
+
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+#include "actions.hpp"
+#include "solver.hpp"
+
+
+constexpr int MAX_PROGRESS_PLAN = 32;
+// CP equivalent of a touch with its share of buffs, and what those buffs add to it on average.
+// Tuned on the batch samples
+constexpr float TOUCH_COST = 25.f;
+constexpr float BUFF_GAIN = 1.5f;
+
+// Everything the quality phase may use. Synthesis comes from the progress plans,
+// except Delicate Synthesis, which builds Inner Quiet too
+static const ACTION quality_actions[] = {
+	BASIC_TOUCH,
+	STANDARD_TOUCH,
+	ADVANCED_TOUCH,
+	PRUDENT_TOUCH,
+	PREPARATORY_TOUCH,
+	TRAINED_FINESSE,
+	REFINED_TOUCH,
+	REFLECT,
+	BYREGOTS_BLESSING,
+	DELICATE_SYNTHESIS,
+	INNOVATION,
+	GREAT_STRIDES,
+	WASTE_NOT,
+	WASTE_NOT_II,
+	MANIPULATION,
+	MASTERS_MEND,
+	IMMACULATE_MEND,
+	OBSERVE,
+	TRAINED_PERFECTION
+};
+
+// A GameState without the tree bookkeeping, so a step's states can be sorted and copied.
+// Everything before quality is the DP key
+struct PhaseNode {
+	int progress;
+	int durability;
+	int cp;
+	int step;
+	int used_action_idx;
+	int trained_perfection_charges;
+	EffectState effects[EFFECT_COUNT];
+	int quality;
+	int trail;		// Last link of the actions leading here, -1 for none
+	float potential;
+};
+
+// Actions taken, linked back to the start
+struct TrailLink {
+	int prev;
+	ACTION action;
+};
+
+struct PhaseBest {
+	bool found = false;
+	int quality = 0;	// Capped at target_quality
+	int steps = 0;
+	std::vector<ACTION> actions;
+};
+
+static PhaseNode toNode(const GameState& state, int trail) {
+	PhaseNode node = {};
+	node.progress = state.progress;
+	node.durability = state.durability;
+	node.cp = state.cp;
+	node.step = state.step;
+	node.used_action_idx = state.used_action_idx;
+	node.trained_perfection_charges = state.trained_perfection_charges;
+	memcpy(node.effects, state.effects, sizeof(node.effects));
+	node.quality = state.quality;
+	node.trail = trail;
+	return node;
+}
+
+static void toGameState(const PhaseNode& node, GameState& state) {
+	state.progress = node.progress;
+	state.quality = node.quality;
+	state.durability = node.durability;
+	state.cp = node.cp;
+	state.step = node.step;
+	state.used_action_idx = node.used_action_idx;
+	state.trained_perfection_charges = node.trained_perfection_charges;
+	memcpy(state.effects, node.effects, sizeof(state.effects));
+}
+
+static bool sameKey(const PhaseNode& a, const PhaseNode& b) {
+	return memcmp(&a, &b, offsetof(PhaseNode, quality)) == 0;
+}
+
+// Same key together, best quality first
+static bool keyThenQuality(const PhaseNode& a, const PhaseNode& b) {
+	int c = memcmp(&a, &b, offsetof(PhaseNode, quality));
+	return c != 0 ? c < 0 : a.quality > b.quality;
+}
+
+float qualityPotential(const GameContext& ctx, const ProgressOracle& oracle, const GameState& state, int max_steps) {
+	int progress_steps = 0;
+	float progress_cost = .0f;
+	progressBounds(oracle, state, progress_steps, progress_cost);
+	float budget = state.cp + oracle.cp_per_durability * (state.durability - 1) - progress_cost;
+	float touches = std::min((float)(max_steps - state.step - progress_steps), budget / TOUCH_COST);
+	touches = std::max(.0f, touches);
+	float inner_quiet = std::min(10.f, state.effects[E_INNER_QUIET].n_stacks + touches * .5f);
+	return state.quality + touches * ctx.base_quality_increase * (1.f + .1f * inner_quiet) * BUFF_GAIN;
+}
+
+static bool step(const GameContext& ctx, GameState& state, ACTION a) {
+	if (!canExecuteAction(ctx, state, a)) {
+		return false;
+	}
+	++state.step;
+	applyAction(ctx, state, a);
+	return true;
+}
+
+static void readTrail(const std::vector<TrailLink>& trails, int trail, std::vector<ACTION>& out) {
+	out.clear();
+	for (int t = trail; t >= 0; t = trails[t].prev) {
+		out.push_back(trails[t].action);
+	}
+	std::reverse(out.begin(), out.end());
+}
+
+static void recordFinished(const GameContext& ctx, const GameState& state, const std::vector<TrailLink>& trails, int trail, const ACTION* tail, int tail_len, PhaseBest& best) {
+	int quality = std::min(state.quality, ctx.target_quality);
+	if (best.found && (quality < best.quality || (quality == best.quality && state.step >= best.steps))) {
+		return;
+	}
+	best.found = true;
+	best.quality = quality;
+	best.steps = state.step;
+	readTrail(trails, trail, best.actions);
+	best.actions.insert(best.actions.end(), tail, tail + tail_len);
+}
+
+// Closes 'node' out with the oracle's cheapest progress plan, simulated exactly.
+// Falls back to Careful and Basic Synthesis when the plan runs out of durability
+static void finishProgress(const GameContext& ctx, const ProgressOracle& oracle, const PhaseNode& node, int max_steps, const std::vector<TrailLink>& trails, PhaseBest& best) {
+	GameState start{};
+	toGameState(node, start);
+	ACTION tail[MAX_PROGRESS_PLAN];
+	int len = cheapestProgressPlan(oracle, start, tail, MAX_PROGRESS_PLAN);
+	for (int attempt = 0; attempt < 2; ++attempt) {
+		GameState state{};
+		state.inheritState(start);
+		int n = 0;
+		while (state.progress < ctx.target_progress && state.step < max_steps && n < MAX_PROGRESS_PLAN) {
+			ACTION a = n < len ? tail[n] : BASIC_SYNTHESIS;
+			if (attempt == 1) {
+				a = canExecuteAction(ctx, state, CAREFUL_SYNTHESIS) ? CAREFUL_SYNTHESIS : BASIC_SYNTHESIS;
+			}
+			if (!step(ctx, state, a)) {
+				break;
+			}
+			tail[n++] = a;
+			if (state.durability <= 0) {
+				break;
+			}
+		}
+		if (state.progress >= ctx.target_progress) {
+			recordFinished(ctx, state, trails, node.trail, tail, n, best);
+			return;
+		}
+		len = 0;
+	}
+}
+
+static void searchQuality(const GameContext& ctx, const ProgressOracle& oracle, const PhaseNode& opening, const PhaseSolveParams& params, std::vector<TrailLink>& trails, PhaseBest& best) {
+	std::vector<PhaseNode> layer = { opening };
+	std::vector<PhaseNode> next;
+	while (!layer.empty()) {
+		next.clear();
+		for (const PhaseNode& node : layer) {
+			finishProgress(ctx, oracle, node, params.max_steps, trails, best);
+			if (node.step >= params.max_steps) {
+				continue;
+			}
+			GameState state{};
+			toGameState(node, state);
+			for (ACTION a : quality_actions) {
+				GameState child{};
+				child.inheritState(state);
+				if (!step(ctx, child, a)) {
+					continue;
+				}
+				trails.push_back(TrailLink{ .prev = node.trail, .action = a });
+				int trail = (int)trails.size() - 1;
+				if (child.progress >= ctx.target_progress) {
+					recordFinished(ctx, child, trails, trail, 0, 0, best);
+					continue;
+				}
+				if (child.durability <= 0 || !canStillFinish(oracle, child, params.max_steps - child.step)) {
+					continue;
+				}
+				next.push_back(toNode(child, trail));
+				next.back().potential = qualityPotential(ctx, oracle, child, params.max_steps);
+			}
+		}
+
+		// Only the best quality per state carries on
+		std::sort(next.begin(), next.end(), keyThenQuality);
+		next.erase(std::unique(next.begin(), next.end(), sameKey), next.end());
+		if ((int)next.size() > params.beam_width) {
+			std::nth_element(next.begin(), next.begin() + params.beam_width, next.end(), [](const PhaseNode& a, const PhaseNode& b) {
+				return a.potential > b.potential;
+			});
+			next.resize(params.beam_width);
+		}
+		std::swap(layer, next);
+	}
+}
+
+bool solveByPhases(const GameContext& ctx, const ProgressOracle& oracle, const GameState& start, const PhaseSolveParams& params, std::vector<ACTION>& plan) {
+	std::vector<TrailLink> trails;
+	std::vector<PhaseNode> openings = { toNode(start, -1) };
+
+	GameState state{};
+	state.inheritState(start);
+	if (step(ctx, state, MUSCLE_MEMORY)) {
+		trails.push_back(TrailLink{ .prev = -1, .action = MUSCLE_MEMORY });
+		openings.push_back(toNode(state, (int)trails.size() - 1));
+		ACTION progress_plan[MAX_PROGRESS_PLAN];
+		int len = cheapestProgressPlan(oracle, state, progress_plan, MAX_PROGRESS_PLAN);
+		for (int i = 0; i < len && state.step < params.max_steps; ++i) {
+			if (!step(ctx, state, progress_plan[i]) || state.durability <= 0 || state.progress >= ctx.target_progress) {
+				break;
+			}
+			trails.push_back(TrailLink{ .prev = (int)trails.size() - 1, .action = progress_plan[i] });
+			openings.push_back(toNode(state, (int)trails.size() - 1));
+		}
+	}
+
+	PhaseBest best;
+	for (const PhaseNode& opening : openings) {
+		searchQuality(ctx, oracle, opening, params, trails, best);
+	}
+	if (!best.found) {
+		return false;
+	}
+	plan = best.actions;
+	return true;
+}
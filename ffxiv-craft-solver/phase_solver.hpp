@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+#include "game_config.hpp"
+#include "game_state.hpp"
+#include "progress_oracle.hpp"
+
+
+// Phase-decomposed solver: progress and quality are planned apart and merged by exact
+// simulation, which takes milliseconds instead of a tree search.
+// Openings are the start itself and every prefix of the oracle's cheapest progress plan after
+// Muscle Memory. From each, a DP over the quality actions runs step by step, keeping the best
+// quality for every distinct Inner Quiet, buff, durability and CP state and a beam of the most
+// promising ones. Every state it reaches is closed out with the oracle's cheapest progress plan
+// from there, and the best finished craft is the result
+struct PhaseSolveParams {
+	int max_steps = 26;
+	int beam_width = 512;	// States kept per step and opening
+};
+
+// Beam order: quality so far plus the touches the CP, durability and steps left over
+// from progress could still buy
+float qualityPotential(const GameContext& ctx, const ProgressOracle& oracle, const GameState& state, int max_steps);
+
+// Plans from 'start' with an oracle built for ctx. Returns false if no plan finishes the craft
+bool solveByPhases(const GameContext& ctx, const ProgressOracle& oracle, const GameState& start, const PhaseSolveParams& params, std::vector<ACTION>& plan);
@@ -0,0 +1,127 @@
+#include "portfolio.hpp"
+
+#include <string.h>
+#include <algorithm>
+#include <thread>
+#include <memory>
+
+
+// Cheapest any touch gets past the first step, a combo touch or Basic Touch
+constexpr int CHEAPEST_TOUCH_CP = 18;
+// Innovation and Great Strides together
+constexpr float BEST_BUFF_MUL = 2.5f;
+// Enough for replaying a sequence engine's result and the post-pass
+constexpr int SEQUENCE_ENGINE_POOL_SIZE = 1 << 14;
+
+int qualityCeiling(const GameContext& ctx, const GameState& state, int steps_left) {
+	if (state.progress >= ctx.target_progress || steps_left <= 0) {
+		return std::min(state.quality, ctx.target_quality);
+	}
+	// Reflect opens at 6 CP and isn't worth modelling for one step
+	if (state.step == 0) {
+		return ctx.target_quality;
+	}
+	int touches = std::min(steps_left, state.cp / CHEAPEST_TOUCH_CP);
+	int inner_quiet = state.effects[E_INNER_QUIET].n_stacks;
+	float gain = .0f;
+	for (int k = 0; k < touches && state.quality + gain < ctx.target_quality; ++k) {
+		int stacks = std::min(10, inner_quiet + 2 * k);
+		// Preparatory Touch, or Byregot's Blessing once it pays more
+		float efficiency = std::max(2.f, 1.f + .2f * stacks);
+		gain += ctx.base_quality_increase * efficiency * (1.f + .1f * stacks) * BEST_BUFF_MUL;
+	}
+	return (int)std::min((float)ctx.target_quality, state.quality + gain + 1.f);
+}
+
+void raiseIncumbent(std::atomic<int>& incumbent, int quality) {
+	int current = incumbent.load(std::memory_order_relaxed);
+	while (quality > current && !incumbent.compare_exchange_weak(current, quality, std::memory_order_relaxed)) {
+	}
+}
+
+bool belowIncumbent(const GameContext& ctx, const GameState& state, int steps_left, const std::atomic<int>* incumbent) {
+	if (!incumbent) {
+		return false;
+	}
+	// Quality isn't capped by the simulator, only by what counts
+	int best = std::min(ctx.target_quality, incumbent->load(std::memory_order_relaxed));
+	return best >= 0 && qualityCeiling(ctx, state, steps_left) < best;
+}
+
+static bool betterResult(const GameContext& ctx, const SolveResult& a, const SolveResult& b) {
+	int qa = std::min(a.quality, ctx.target_quality);
+	int qb = std::min(b.quality, ctx.target_quality);
+	if (qa != qb) {
+		return qa > qb;
+	}
+	return a.cp > b.cp;
+}
+
+PortfolioResult solvePortfolio(const GameContext& ctx, const SolveParams& params, const std::vector<SOLVE_ENGINE>& engines, int pool_size) {
+	PortfolioResult result;
+	std::atomic<int> own_incumbent{ -1 };
+	std::atomic<int>* incumbent = params.incumbent ? params.incumbent : &own_incumbent;
+
+	std::vector<std::unique_ptr<Solver>> solvers;
+	std::vector<SolveHandle> handles;
+	for (SOLVE_ENGINE engine : engines) {
+		solvers.emplace_back(new Solver(engine == ENGINE_MCTS ? pool_size : std::min(pool_size, SEQUENCE_ENGINE_POOL_SIZE)));
+		SolveParams p = params;
+		p.engine = engine;
+		p.incumbent = incumbent;
+		handles.push_back(solveAsync(*solvers.back(), ctx, p));
+	}
+
+	// Engines stop on the deadline by themselves, the rest is for the caller's cancel and a proven optimum
+	for (;;) {
+		bool all_done = std::all_of(handles.begin(), handles.end(), [](const SolveHandle& h) {
+			return h.isDone();
+		});
+		if (all_done) {
+			break;
+		}
+		bool stop = break_requested || (params.cancel && params.cancel->load(std::memory_order_relaxed));
+		if (incumbent->load(std::memory_order_relaxed) >= ctx.target_quality) {
+			result.optimal = true;
+			stop = true;
+		}
+		if (stop) {
+			for (SolveHandle& h : handles) {
+				h.cancel();
+			}
+			break;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+
+	for (size_t i = 0; i < handles.size(); ++i) {
+		result.runs.push_back(handles[i].get());
+		if (result.runs[i].found && (result.winner < 0 || betterResult(ctx, result.runs[i], result.best))) {
+			result.best = result.runs[i];
+			result.winner = (int)i;
+		}
+	}
+	result.optimal = result.optimal || (result.best.found && result.best.quality >= ctx.target_quality);
+	return result;
+}
+
+bool parseEngineList(const char* s, std::vector<SOLVE_ENGINE>& out) {
+	out.clear();
+	char name[16];
+	while (*s) {
+		const char* end = strchr(s, ',');
+		size_t len = end ? (size_t)(end - s) : strlen(s);
+		if (len == 0 || len >= sizeof(name)) {
+			return false;
+		}
+		memcpy(name, s, len);
+		name[len] = '\0';
+		SOLVE_ENGINE engine;
+		if (!engineFromString(name, engine)) {
+			return false;
+		}
+		out.push_back(engine);
+		s += len + (end ? 1 : 0);
+	}
+	return !out.empty();
+}
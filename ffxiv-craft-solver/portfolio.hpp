@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include "game_config.hpp"
+#include "game_state.hpp"
+#include "solver.hpp"
+
+
+// Portfolio solve: several engines run at once, each on its own thread and Solver, and share
+// an incumbent, the best quality any of them has finished the craft with. Every engine raises
+// it as it finishes crafts and drops branches whose quality ceiling can't beat it.
+// The run ends when every engine has stopped, on the deadline, or as soon as the incumbent
+// reaches target_quality, since nothing can score above that
+
+// Most quality 'state' could still end with in 'steps_left' actions, capped at target_quality.
+// Every step and every 18 CP is counted as a touch at full buffs with Inner Quiet growing by
+// two, the last one a Byregot's Blessing
+int qualityCeiling(const GameContext& ctx, const GameState& state, int steps_left);
+
+// Lock-free, the incumbent only ever grows
+void raiseIncumbent(std::atomic<int>& incumbent, int quality);
+// True if 'state' can't end strictly above 'incumbent'. False without one
+bool belowIncumbent(const GameContext& ctx, const GameState& state, int steps_left, const std::atomic<int>* incumbent);
+
+struct PortfolioResult {
+	SolveResult best;
+	int winner = -1;		// Index into the engine list of the best run, -1 if none finished
+	bool optimal = false;	// The incumbent reached target_quality
+	std::vector<SolveResult> runs;	// One per engine, in list order
+};
+
+// Runs every engine in 'engines' with 'params' on a Solver of its own. MCTS gets a pool of
+// 'pool_size' states, the sequence engines only need a small one for replaying what they find.
+// The incumbent, cancel token and deadline of 'params' are shared by all of them
+PortfolioResult solvePortfolio(const GameContext& ctx, const SolveParams& params, const std::vector<SOLVE_ENGINE>& engines, int pool_size);
+
+// Comma separated engine names. False on an unknown one
+bool parseEngineList(const char* s, std::vector<SOLVE_ENGINE>& out);
@@ -0,0 +1,114 @@
+#include "prefix_cache.hpp"
+
+#include <string.h>
+#include <algorithm>
+#include "portfolio.hpp"
+#include "solver.hpp"
+
+
+constexpr int CHILD_UNKNOWN = -1;
+constexpr int CHILD_DEAD = -2;
+
+PrefixCache::PrefixCache(const GameContext& ctx, const GameState& start, const ProgressOracle* oracle, int max_steps,
+	const std::atomic<int>* incumbent, int max_nodes)
+	: ctx(ctx), oracle(oracle), max_steps(max_steps), incumbent(incumbent), max_nodes(std::max(2, max_nodes)) {
+	nodes.reserve(this->max_nodes);
+	nodes.emplace_back();
+	store(start, nodes[0]);
+}
+
+void PrefixCache::store(const GameState& state, Node& node) const {
+	node.progress = state.progress;
+	node.quality = state.quality;
+	node.durability = state.durability;
+	node.cp = state.cp;
+	node.step = state.step;
+	node.used_action_idx = state.used_action_idx;
+	node.trained_perfection_charges = state.trained_perfection_charges;
+	memcpy(node.effects, state.effects, sizeof(node.effects));
+	node.cp_used_on_progress = state.cp_used_on_progress;
+	node.durability_used_on_progress = state.durability_used_on_progress;
+	node.cp_used_on_quality = state.cp_used_on_quality;
+	node.durability_used_on_quality = state.durability_used_on_quality;
+	node.wasted_durability = state.wasted_durability;
+	node.children = -1;
+}
+
+void PrefixCache::load(int idx, GameState& state) const {
+	const Node& node = nodes[idx];
+	state.progress = node.progress;
+	state.quality = node.quality;
+	state.durability = node.durability;
+	state.cp = node.cp;
+	state.step = node.step;
+	state.used_action_idx = node.used_action_idx;
+	state.trained_perfection_charges = node.trained_perfection_charges;
+	memcpy(state.effects, node.effects, sizeof(state.effects));
+	state.cp_used_on_progress = node.cp_used_on_progress;
+	state.durability_used_on_progress = node.durability_used_on_progress;
+	state.cp_used_on_quality = node.cp_used_on_quality;
+	state.durability_used_on_quality = node.durability_used_on_quality;
+	state.wasted_durability = node.wasted_durability;
+}
+
+int PrefixCache::begin() {
+	if ((int)nodes.size() > max_nodes) {
+		nodes.resize(1);
+		nodes[0].children = -1;
+		child_table.clear();
+		scratch_parent_idx = -1;
+	}
+	return 0;
+}
+
+int PrefixCache::child(int idx, ACTION a) {
+	if (nodes[idx].children >= 0) {
+		int c = child_table[nodes[idx].children + a];
+		if (c != CHILD_UNKNOWN) {
+			++hits;
+			return c == CHILD_DEAD ? -1 : c;
+		}
+	}
+	++misses;
+	if (scratch_parent_idx != idx) {
+		load(idx, scratch_parent);
+		scratch_parent_idx = idx;
+	}
+	if (nodes[idx].children < 0) {
+		nodes[idx].children = (int)child_table.size();
+		child_table.resize(child_table.size() + ACTION_COUNT, CHILD_UNKNOWN);
+	}
+	int& slot = child_table[nodes[idx].children + a];
+	if (!canExecuteAction(ctx, scratch_parent, a)) {
+		slot = CHILD_DEAD;
+		return -1;
+	}
+	scratch.inheritState(scratch_parent);
+	++scratch.step;
+	applyAction(ctx, scratch, a);
+	if (scratch.progress < ctx.target_progress && ((oracle && !canStillFinish(*oracle, scratch, max_steps - scratch.step))
+		|| belowIncumbent(ctx, scratch, max_steps - scratch.step, incumbent))) {
+		slot = CHILD_DEAD;
+		return -1;
+	}
+	slot = (int)nodes.size();
+	nodes.emplace_back();
+	store(scratch, nodes.back());
+	return slot;
+}
+
+int PrefixCache::play(const ACTION* seq, int len, int max_steps, GameState& end) {
+	int node = begin();
+	int n = 0;
+	while (n < len && nodes[node].step < max_steps
+		&& nodes[node].durability > 0 && nodes[node].progress < ctx.target_progress) {
+		int next = child(node, seq[n]);
+		if (next < 0) {
+			break;
+		}
+		node = next;
+		++n;
+	}
+	load(node, end);
+	return n;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+#include "game_config.hpp"
+#include "game_state.hpp"
+#include "progress_oracle.hpp"
+
+
+// Trie of the states after every action prefix played from one start, so sequences that share
+// a prefix with one seen before only simulate their new suffix. Nodes are packed GameStates
+// without the tree bookkeeping, each with a table of its children by action once it has any.
+// Moves that can't execute are remembered as dead ends, and with an oracle so are moves that
+// leave progress out of reach within max_steps, and with an incumbent those that leave quality
+// unable to beat it. The incumbent only grows, so a dead end stays dead. A walk that begins
+// with more than max_nodes cached starts the trie over.
+// Not thread safe, sequence engines keep one per thread
+class PrefixCache {
+public:
+	PrefixCache(const GameContext& ctx, const GameState& start, const ProgressOracle* oracle = 0, int max_steps = 0,
+		const std::atomic<int>* incumbent = 0, int max_nodes = 1 << 16);
+
+	// Starts a walk and returns the root. Nodes stay valid until the next begin()
+	int begin();
+	// Node after playing 'a' from 'node', simulated on first use. -1 for a dead end
+	int child(int node, ACTION a);
+	void load(int node, GameState& state) const;
+
+	// Plays 'seq' from the start until an action can't execute, the craft ends or max_steps is
+	// reached. Returns how many actions were played, 'end' is the state they lead to
+	int play(const ACTION* seq, int len, int max_steps, GameState& end);
+
+	int64_t hits = 0;
+	int64_t misses = 0;
+
+private:
+	struct Node {
+		int progress;
+		int quality;
+		int durability;
+		int cp;
+		int step;
+		int used_action_idx;
+		int trained_perfection_charges;
+		EffectState effects[EFFECT_COUNT];
+		// Kept for monteCarloScore
+		int cp_used_on_progress;
+		int durability_used_on_progress;
+		int cp_used_on_quality;
+		int durability_used_on_quality;
+		int wasted_durability;
+
+		int children;	// Offset into child_table, -1 until the first child
+	};
+
+	void store(const GameState& state, Node& node) const;
+
+	GameContext ctx;
+	const ProgressOracle* oracle;
+	int max_steps;
+	const std::atomic<int>* incumbent;
+	int max_nodes;
+	std::vector<Node> nodes;
+	std::vector<int> child_table;	// ACTION_COUNT entries per node with children
+	// Misses simulate here, and repeated misses from one node load it only once
+	GameState scratch;
+	GameState scratch_parent;
+	int scratch_parent_idx = -1;
+};
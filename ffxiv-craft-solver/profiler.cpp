@@ -0,0 +1,166 @@
+#include "profiler.hpp"
+
+#ifdef SOLVER_PROFILE
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+
+static const char* phase_names[] = { "select", "expand", "simulate", "backprop" };
+static const char* counter_names[] = {
+	"select depth", "expand probes", "rollout probes", "rollout length",
+	"backprop length", "endgame hits", "hopeless rollouts", "alloc calls", "free calls"
+};
+static_assert(sizeof(phase_names) / sizeof(phase_names[0]) == PROFILE_PHASE_COUNT, "phase_names mismatch");
+static_assert(sizeof(counter_names) / sizeof(counter_names[0]) == PROFILE_COUNTER_COUNT, "counter_names mismatch");
+
+// Trace spans beyond this are only counted, a 2M iteration run would otherwise produce gigabytes
+constexpr size_t MAX_TRACE_EVENTS_PER_THREAD = 1'000'000;
+
+struct TraceEvent {
+	uint8_t phase;
+	int64_t start_ns;
+	int64_t duration_ns;
+};
+
+struct PhaseStats {
+	int64_t calls = 0;
+	int64_t total_ns = 0;
+	int64_t max_ns = 0;
+};
+
+struct CounterStats {
+	int64_t samples = 0;
+	int64_t total = 0;
+	int64_t max = 0;
+};
+
+struct ThreadProfile {
+	int tid;
+	PhaseStats phases[PROFILE_PHASE_COUNT];
+	CounterStats counters[PROFILE_COUNTER_COUNT];
+	std::vector<TraceEvent> trace;
+};
+
+static std::mutex registry_mutex;
+static std::vector<ThreadProfile*> registry;
+static const auto epoch = std::chrono::steady_clock::now();
+
+static inline int64_t nowNs() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+static ThreadProfile* threadProfile() {
+	// Intentionally leaked so reports still work after the thread exits
+	static thread_local ThreadProfile* profile = 0;
+	if (!profile) {
+		profile = new ThreadProfile();
+		std::lock_guard<std::mutex> lock(registry_mutex);
+		profile->tid = (int)registry.size() + 1;
+		registry.push_back(profile);
+	}
+	return profile;
+}
+
+ProfileScope::ProfileScope(PROFILE_PHASE phase)
+	: phase(phase), start_ns(nowNs()) {}
+
+ProfileScope::~ProfileScope() {
+	int64_t duration = nowNs() - start_ns;
+	ThreadProfile* p = threadProfile();
+	PhaseStats& stats = p->phases[phase];
+	++stats.calls;
+	stats.total_ns += duration;
+	stats.max_ns = std::max(stats.max_ns, duration);
+	if (p->trace.size() < MAX_TRACE_EVENTS_PER_THREAD) {
+		p->trace.push_back(TraceEvent{ (uint8_t)phase, start_ns, duration });
+	}
+}
+
+void profilerCount(PROFILE_COUNTER counter, int64_t value) {
+	CounterStats& stats = threadProfile()->counters[counter];
+	++stats.samples;
+	stats.total += value;
+	stats.max = std::max(stats.max, value);
+}
+
+void profilerReport(FILE* f) {
+	PhaseStats phases[PROFILE_PHASE_COUNT];
+	CounterStats counters[PROFILE_COUNTER_COUNT];
+	{
+		std::lock_guard<std::mutex> lock(registry_mutex);
+		for (ThreadProfile* p : registry) {
+			for (int i = 0; i < PROFILE_PHASE_COUNT; ++i) {
+				phases[i].calls += p->phases[i].calls;
+				phases[i].total_ns += p->phases[i].total_ns;
+				phases[i].max_ns = std::max(phases[i].max_ns, p->phases[i].max_ns);
+			}
+			for (int i = 0; i < PROFILE_COUNTER_COUNT; ++i) {
+				counters[i].samples += p->counters[i].samples;
+				counters[i].total += p->counters[i].total;
+				counters[i].max = std::max(counters[i].max, p->counters[i].max);
+			}
+		}
+	}
+
+	int64_t total_ns = 0;
+	for (int i = 0; i < PROFILE_PHASE_COUNT; ++i) {
+		total_ns += phases[i].total_ns;
+	}
+
+	fprintf(f, "%-16s %12s %12s %10s %10s %7s\n", "phase", "calls", "total ms", "avg us", "max us", "share");
+	for (int i = 0; i < PROFILE_PHASE_COUNT; ++i) {
+		const PhaseStats& s = phases[i];
+		fprintf(f, "%-16s %12lld %12.1f %10.3f %10.1f %6.1f%%\n",
+			phase_names[i], (long long)s.calls,
+			s.total_ns * 1e-6,
+			s.calls ? s.total_ns * 1e-3 / s.calls : .0,
+			s.max_ns * 1e-3,
+			total_ns ? 100.0 * s.total_ns / total_ns : .0
+		);
+	}
+	fprintf(f, "\n%-16s %12s %14s %10s %10s\n", "counter", "samples", "total", "avg", "max");
+	for (int i = 0; i < PROFILE_COUNTER_COUNT; ++i) {
+		const CounterStats& s = counters[i];
+		fprintf(f, "%-16s %12lld %14lld %10.2f %10lld\n",
+			counter_names[i], (long long)s.samples, (long long)s.total,
+			s.samples ? s.total / (double)s.samples : .0,
+			(long long)s.max
+		);
+	}
+	if (phases[PP_SIMULATE].total_ns) {
+		fprintf(f, "\nrollout steps/sec: %.0f\n", counters[PC_ROLLOUT_LENGTH].total / (phases[PP_SIMULATE].total_ns * 1e-9));
+	}
+}
+
+bool profilerWriteChromeTrace(const char* path) {
+	FILE* f = fopen(path, "w");
+	if (!f) {
+		return false;
+	}
+	fprintf(f, "{\"traceEvents\":[\n");
+	bool first = true;
+	std::lock_guard<std::mutex> lock(registry_mutex);
+	for (ThreadProfile* p : registry) {
+		for (const TraceEvent& e : p->trace) {
+			fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%i,\"ts\":%.3f,\"dur\":%.3f}",
+				first ? "" : ",\n", phase_names[e.phase], p->tid, e.start_ns * 1e-3, e.duration_ns * 1e-3
+			);
+			first = false;
+		}
+	}
+	fprintf(f, "\n]}\n");
+	return fclose(f) == 0;
+}
+
+#else
+
+void profilerReport(FILE* f) {}
+
+bool profilerWriteChromeTrace(const char* path) {
+	return false;
+}
+
+#endif
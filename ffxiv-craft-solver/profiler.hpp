@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+
+
+// Per-phase MCTS instrumentation. Compiled in only with SOLVER_PROFILE defined,
+// otherwise the macros expand to nothing and the report functions are no-ops
+
+enum PROFILE_PHASE {
+	PP_SELECT,
+	PP_EXPAND,
+	PP_SIMULATE,
+	PP_BACKPROP,
+
+	PROFILE_PHASE_COUNT
+};
+
+enum PROFILE_COUNTER {
+	PC_SELECT_DEPTH,		// Depth of the node monteCarloSelect2 returned
+	PC_EXPAND_PROBES,		// executeAction calls spent testing legality on expansion
+	PC_ROLLOUT_PROBES,		// Same, inside rollouts
+	PC_ROLLOUT_LENGTH,		// Steps played per rollout
+	PC_BACKPROP_LENGTH,		// Nodes updated per propagateScore
+	PC_ENDGAME_HITS,		// Rollouts finished from the endgame table
+	PC_HOPELESS_ROLLOUTS,	// Rollouts cut once target_progress was out of reach
+	PC_ALLOC_CALLS,
+	PC_FREE_CALLS,
+
+	PROFILE_COUNTER_COUNT
+};
+
+#ifdef SOLVER_PROFILE
+
+struct ProfileScope {
+	PROFILE_PHASE phase;
+	int64_t start_ns;
+
+	ProfileScope(PROFILE_PHASE phase);
+	~ProfileScope();
+};
+
+void profilerCount(PROFILE_COUNTER counter, int64_t value);
+
+#define PROFILE_SCOPE(phase) ProfileScope _profile_scope(phase)
+#define PROFILE_COUNT(counter, value) profilerCount(counter, value)
+
+#else
+
+#define PROFILE_SCOPE(phase)
+#define PROFILE_COUNT(counter, value)
+
+#endif
+
+// Summary table of all threads' phases and counters
+void profilerReport(FILE* f);
+// Chrome trace (chrome://tracing, Perfetto) of the first recorded phase spans
+bool profilerWriteChromeTrace(const char* path);
@@ -0,0 +1,171 @@
+#include "progress_oracle.hpp"
+
+#include <float.h>
+#include <algorithm>
+#include "actions.hpp"
+
+
+constexpr int VENERATION_CHARGES = 5;
+constexpr int MUSCLE_MEMORY_CHARGES = 6;
+constexpr uint8_t UNREACHABLE_STEPS = 255;
+
+static const ACTION progress_actions[] = {
+	BASIC_SYNTHESIS,
+	CAREFUL_SYNTHESIS,
+	PRUDENT_SYNTHESIS,
+	GROUNDWORK,
+	DELICATE_SYNTHESIS
+};
+
+static int oracleIndex(int progress, int veneration, int muscle_memory) {
+	return (progress * VENERATION_CHARGES + veneration) * MUSCLE_MEMORY_CHARGES + muscle_memory;
+}
+
+// Same rounding as applyAction
+static int progressGain(const GameContext& ctx, ACTION a, int veneration, int muscle_memory) {
+	float progress = ctx.base_progress_increase * actions[a].progress_efficiency;
+	float veneration_mul = veneration > 0 ? 0.5f : 0.f;
+	float muscle_memory_mul = muscle_memory > 0 ? 1.f : .0f;
+	return (int)(progress + progress * veneration_mul + progress * muscle_memory_mul);
+}
+
+static float cheapestDurability(const GameContext& ctx) {
+	float rate = actions[MASTERS_MEND].cp_cost / (float)-actions[MASTERS_MEND].durability_cost;
+	rate = std::min(rate, actions[MANIPULATION].cp_cost / (actions[MANIPULATION].effect_charges * 5.f));
+	// Waste Not saves the most on Groundwork
+	float most_saved = actions[GROUNDWORK].durability_cost / 2.f;
+	rate = std::min(rate, actions[WASTE_NOT].cp_cost / (actions[WASTE_NOT].effect_charges * most_saved));
+	rate = std::min(rate, actions[WASTE_NOT_II].cp_cost / (actions[WASTE_NOT_II].effect_charges * most_saved));
+	if (ctx.max_durability > 1) {
+		rate = std::min(rate, actions[IMMACULATE_MEND].cp_cost / (float)(ctx.max_durability - 1));
+	}
+	return rate;
+}
+
+static float actionCost(const ProgressOracle& oracle, ACTION a) {
+	return actions[a].cp_cost + oracle.cp_per_durability * actions[a].durability_cost;
+}
+
+void buildProgressOracle(const GameContext& ctx, ProgressOracle& oracle) {
+	oracle.ctx = ctx;
+	oracle.max_progress = std::max(0, ctx.target_progress);
+	oracle.cp_per_durability = cheapestDurability(ctx);
+	size_t n = (size_t)(oracle.max_progress + 1) * VENERATION_CHARGES * MUSCLE_MEMORY_CHARGES;
+	oracle.min_steps.assign(n, UNREACHABLE_STEPS);
+	oracle.min_cost.assign(n, FLT_MAX);
+	for (int v = 0; v < VENERATION_CHARGES; ++v) {
+		for (int m = 0; m < MUSCLE_MEMORY_CHARGES; ++m) {
+			oracle.min_steps[oracleIndex(0, v, m)] = 0;
+			oracle.min_cost[oracleIndex(0, v, m)] = .0f;
+		}
+	}
+
+	for (int x = 1; x <= oracle.max_progress; ++x) {
+		for (int m = 0; m < MUSCLE_MEMORY_CHARGES; ++m) {
+			// Full Veneration first, every other charge count can recast into it
+			for (int v = VENERATION_CHARGES - 1; v >= 0; --v) {
+				int steps = UNREACHABLE_STEPS;
+				float cost = FLT_MAX;
+				// Progress uses up Muscle Memory
+				for (ACTION a : progress_actions) {
+					int rest = std::max(0, x - progressGain(ctx, a, v, m));
+					int j = oracleIndex(rest, std::max(0, v - 1), 0);
+					steps = std::min(steps, oracle.min_steps[j] + 1);
+					cost = std::min(cost, actionCost(oracle, a) + oracle.min_cost[j]);
+				}
+				if (v != VENERATION_CHARGES - 1 || m != 0) {
+					int j = oracleIndex(x, VENERATION_CHARGES - 1, std::max(0, m - 1));
+					steps = std::min(steps, oracle.min_steps[j] + 1);
+					cost = std::min(cost, actions[VENERATION].cp_cost + oracle.min_cost[j]);
+				}
+				// A capped step count is still a lower bound
+				oracle.min_steps[oracleIndex(x, v, m)] = (uint8_t)std::min(steps, UNREACHABLE_STEPS - 1);
+				oracle.min_cost[oracleIndex(x, v, m)] = cost;
+			}
+		}
+	}
+}
+
+bool progressOracleMatches(const ProgressOracle& oracle, const GameContext& ctx) {
+	return !oracle.min_steps.empty()
+		&& oracle.ctx.base_progress_increase == ctx.base_progress_increase
+		&& oracle.ctx.target_progress == ctx.target_progress
+		&& oracle.ctx.max_durability == ctx.max_durability;
+}
+
+bool canStillFinish(const ProgressOracle& oracle, const GameState& state, int steps_left) {
+	int x = oracle.ctx.target_progress - state.progress;
+	// Muscle Memory is only open on the first step and isn't in the tables
+	if (x <= 0 || state.step == 0) {
+		return true;
+	}
+	if (state.durability <= 0 || x > oracle.max_progress) {
+		return false;
+	}
+	int v = std::min(VENERATION_CHARGES - 1, (int)state.effects[E_VENERATION].n_charges);
+	int m = std::min(MUSCLE_MEMORY_CHARGES - 1, (int)state.effects[E_MUSCLE_MEMORY].n_charges);
+	int i = oracleIndex(x, v, m);
+	if (oracle.min_steps[i] > steps_left) {
+		return false;
+	}
+
+	// The finishing action may take durability below zero, and what running
+	// buffs will still save is already paid for
+	const int most_spent = actions[GROUNDWORK].durability_cost;
+	int durability = state.durability - 1 + most_spent;
+	if (state.trained_perfection_charges > 0 || state.effects[E_TRAINED_PERFECTION].n_stacks > 0) {
+		durability += most_spent;
+	}
+	durability += state.effects[E_WASTE_NOT].n_charges * most_spent / 2;
+	durability += state.effects[E_MANIPULATION].n_charges * 5;
+	return oracle.min_cost[i] <= state.cp + oracle.cp_per_durability * durability + 1e-3f;
+}
+
+bool progressBounds(const ProgressOracle& oracle, const GameState& state, int& min_steps, float& min_cost) {
+	int x = std::max(0, oracle.ctx.target_progress - state.progress);
+	if (x > oracle.max_progress) {
+		return false;
+	}
+	int v = std::min(VENERATION_CHARGES - 1, (int)state.effects[E_VENERATION].n_charges);
+	int m = std::min(MUSCLE_MEMORY_CHARGES - 1, (int)state.effects[E_MUSCLE_MEMORY].n_charges);
+	int i = oracleIndex(x, v, m);
+	min_steps = oracle.min_steps[i];
+	min_cost = oracle.min_cost[i];
+	return true;
+}
+
+int cheapestProgressPlan(const ProgressOracle& oracle, const GameState& state, ACTION* plan, int max_len) {
+	int x = std::min(oracle.max_progress, oracle.ctx.target_progress - state.progress);
+	int v = std::min(VENERATION_CHARGES - 1, (int)state.effects[E_VENERATION].n_charges);
+	int m = std::min(MUSCLE_MEMORY_CHARGES - 1, (int)state.effects[E_MUSCLE_MEMORY].n_charges);
+	int len = 0;
+	// Every step costs something, so following the cheapest move can't loop
+	while (x > 0 && len < max_len) {
+		ACTION best = VENERATION;
+		float best_cost = FLT_MAX;
+		for (ACTION a : progress_actions) {
+			int rest = std::max(0, x - progressGain(oracle.ctx, a, v, m));
+			float cost = actionCost(oracle, a) + oracle.min_cost[oracleIndex(rest, std::max(0, v - 1), 0)];
+			if (cost < best_cost) {
+				best_cost = cost;
+				best = a;
+			}
+		}
+		if (v != VENERATION_CHARGES - 1 || m != 0) {
+			float cost = actions[VENERATION].cp_cost + oracle.min_cost[oracleIndex(x, VENERATION_CHARGES - 1, std::max(0, m - 1))];
+			if (cost < best_cost) {
+				best = VENERATION;
+			}
+		}
+		plan[len++] = best;
+		if (best == VENERATION) {
+			v = VENERATION_CHARGES - 1;
+			m = std::max(0, m - 1);
+		} else {
+			x = std::max(0, x - progressGain(oracle.ctx, best, v, m));
+			v = std::max(0, v - 1);
+			m = 0;
+		}
+	}
+	return len;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "game_config.hpp"
+#include "game_state.hpp"
+
+
+// Lower bounds on what finishing the craft still takes, for every amount of progress to go
+// and Veneration/Muscle Memory charge. Built once per GameContext.
+// The bounds are a relaxation, so a state they reject can never be finished: buffs other than
+// Veneration are free, Groundwork always gets full efficiency, and durability can be bought
+// back at the cheapest CP rate any restoring action offers
+struct ProgressOracle {
+	GameContext ctx = {};
+	int max_progress = 0;
+	float cp_per_durability = .0f;
+	// Indexed by progress to go, then Veneration charges, then Muscle Memory charges
+	std::vector<uint8_t> min_steps;
+	std::vector<float> min_cost;	// CP plus durability at cp_per_durability
+};
+
+void buildProgressOracle(const GameContext& ctx, ProgressOracle& oracle);
+// True if 'oracle' was built for the same craft
+bool progressOracleMatches(const ProgressOracle& oracle, const GameContext& ctx);
+
+// False if 'state' can't reach target_progress within 'steps_left' actions with what it has left
+bool canStillFinish(const ProgressOracle& oracle, const GameState& state, int steps_left);
+
+// Fewest steps and lowest cost in min_cost units 'state' still needs for progress.
+// False if it is past the oracle's range
+bool progressBounds(const ProgressOracle& oracle, const GameState& state, int& min_steps, float& min_cost);
+
+// Cheapest way from 'state' to target_progress by the oracle's costs, Veneration included.
+// Durability is only priced, not checked, so the plan still has to be simulated. Returns its length
+int cheapestProgressPlan(const ProgressOracle& oracle, const GameState& state, ACTION* plan, int max_len);
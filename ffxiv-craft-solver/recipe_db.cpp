@@ -0,0 +1,132 @@
+#include "recipe_db.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+
+constexpr uint32_t RECIPE_DB_MAGIC = 0x42445246; // "FRDB"
+constexpr uint32_t RECIPE_DB_VERSION = 1;
+
+struct RecipeDbHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t record_size;
+	uint32_t count;
+};
+
+bool openRecipeDb(const char* path, RecipeDb& db) {
+	db = RecipeDb();
+	if (!mapFileRead(path, db.file)) {
+		return false;
+	}
+	const RecipeDbHeader* header = (const RecipeDbHeader*)db.file.data;
+	if (db.file.size < sizeof(RecipeDbHeader)
+		|| header->magic != RECIPE_DB_MAGIC
+		|| header->version != RECIPE_DB_VERSION
+		|| header->record_size != sizeof(RecipeRecord)
+		|| db.file.size < sizeof(RecipeDbHeader) + (size_t)header->count * sizeof(RecipeRecord)
+	) {
+		unmapFile(db.file);
+		return false;
+	}
+	db.records = (const RecipeRecord*)(header + 1);
+	db.count = header->count;
+	return true;
+}
+
+void closeRecipeDb(RecipeDb& db) {
+	unmapFile(db.file);
+	db = RecipeDb();
+}
+
+const RecipeRecord* findRecipe(const RecipeDb& db, uint32_t id) {
+	const RecipeRecord* end = db.records + db.count;
+	const RecipeRecord* it = std::lower_bound(db.records, end, id, [](const RecipeRecord& r, uint32_t id)->bool {
+		return r.id < id;
+	});
+	if (it == end || it->id != id) {
+		return 0;
+	}
+	return it;
+}
+
+const RecipeRecord* findRecipeByName(const RecipeDb& db, const char* name) {
+	for (int i = 0; i < db.count; ++i) {
+		if (!strcmp(db.records[i].name, name)) {
+			return &db.records[i];
+		}
+	}
+	return 0;
+}
+
+// One recipe per line:
+// id base_progress base_quality target_progress target_quality durability name...
+// Empty lines and lines starting with '#' are skipped
+bool buildRecipeDb(const char* text_path, const char* db_path) {
+	FILE* in = fopen(text_path, "r");
+	if (!in) {
+		return false;
+	}
+	std::vector<RecipeRecord> records;
+	char line[512];
+	int line_no = 0;
+	while (fgets(line, sizeof(line), in)) {
+		++line_no;
+		line[strcspn(line, "\r\n")] = '\0';
+		const char* p = line + strspn(line, " \t");
+		if (*p == '\0' || *p == '#') {
+			continue;
+		}
+		RecipeRecord r = { 0 };
+		int name_at = 0;
+		if (sscanf(p, "%u %d %d %d %d %d %n",
+			&r.id, &r.base_progress_increase, &r.base_quality_increase,
+			&r.target_progress, &r.target_quality, &r.max_durability, &name_at) != 6
+		) {
+			printf("%s:%i: malformed recipe\n", text_path, line_no);
+			fclose(in);
+			return false;
+		}
+		strncpy(r.name, p + name_at, RECIPE_NAME_LEN - 1);
+		records.push_back(r);
+	}
+	fclose(in);
+
+	std::sort(records.begin(), records.end(), [](const RecipeRecord& a, const RecipeRecord& b)->bool {
+		return a.id < b.id;
+	});
+	for (size_t i = 1; i < records.size(); ++i) {
+		if (records[i].id == records[i - 1].id) {
+			printf("%s: duplicate recipe id %u\n", text_path, records[i].id);
+			return false;
+		}
+	}
+
+	FILE* out = fopen(db_path, "wb");
+	if (!out) {
+		return false;
+	}
+	RecipeDbHeader header = {
+		.magic = RECIPE_DB_MAGIC,
+		.version = RECIPE_DB_VERSION,
+		.record_size = sizeof(RecipeRecord),
+		.count = (uint32_t)records.size()
+	};
+	bool ok = fwrite(&header, sizeof(header), 1, out) == 1
+		&& (records.empty() || fwrite(records.data(), sizeof(RecipeRecord), records.size(), out) == records.size());
+	ok = (fclose(out) == 0) && ok;
+	return ok;
+}
+
+GameContext makeGameContext(const RecipeRecord& recipe, int max_cp) {
+	return GameContext{
+		.base_progress_increase = recipe.base_progress_increase,
+		.base_quality_increase = recipe.base_quality_increase,
+		.max_cp = max_cp,
+		.target_progress = recipe.target_progress,
+		.target_quality = recipe.target_quality,
+		.max_durability = recipe.max_durability
+	};
+}
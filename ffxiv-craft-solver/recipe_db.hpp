@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+#include "game_config.hpp"
+#include "mapped_file.hpp"
+
+
+// Binary recipe database: a small header followed by RecipeRecords sorted by id.
+// The file is mapped read-only, so any number of solver processes share one
+// page-cached copy and lookup is a binary search with no parsing at startup
+
+constexpr int RECIPE_NAME_LEN = 64;
+
+struct RecipeRecord {
+	uint32_t id;
+	char name[RECIPE_NAME_LEN];
+	// Per-step increases for the reference crafter the recipe was entered with
+	int32_t base_progress_increase;
+	int32_t base_quality_increase;
+	int32_t target_progress;
+	int32_t target_quality;
+	int32_t max_durability;
+};
+
+struct RecipeDb {
+	MappedFile file;
+	const RecipeRecord* records = 0;
+	int count = 0;
+};
+
+bool openRecipeDb(const char* path, RecipeDb& db);
+void closeRecipeDb(RecipeDb& db);
+
+const RecipeRecord* findRecipe(const RecipeDb& db, uint32_t id);
+// Case sensitive, linear scan
+const RecipeRecord* findRecipeByName(const RecipeDb& db, const char* name);
+
+// Compiles the text format (see recipes.txt) into the binary format
+bool buildRecipeDb(const char* text_path, const char* db_path);
+
+GameContext makeGameContext(const RecipeRecord& recipe, int max_cp);
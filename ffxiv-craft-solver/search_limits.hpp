@@ -0,0 +1,15 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+
+// How the NRPA, genetic and LDS engines are told to stop early, and the best quality
+// of a portfolio they share. The engines return the best they have found so far once
+// searchLimitsReached (solver.hpp) says so
+struct SearchLimits {
+	const std::atomic<bool>* cancel = 0;
+	std::chrono::steady_clock::time_point deadline = {};	// Epoch means none
+	// Shared best quality of a portfolio, see portfolio.hpp
+	std::atomic<int>* incumbent = 0;
+};
@@ -0,0 +1,290 @@
+#include "solution_cache.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include "actions.hpp"
+
+
+struct SolutionCacheHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t key;
+	uint64_t action_fingerprint;
+	// The craft itself, so a hash collision can't hand back another recipe's macro
+	int32_t base_progress_increase;
+	int32_t base_quality_increase;
+	int32_t max_cp;
+	int32_t target_progress;
+	int32_t target_quality;
+	int32_t max_durability;
+	int32_t progress;
+	int32_t quality;
+	int32_t durability;
+	int32_t cp;
+	int32_t n_iterations;
+	uint32_t n_actions;		// followed by n_actions bytes
+};
+
+static const char SOLUTION_CACHE_MAGIC[4] = { 'F', 'X', 'S', 'C' };
+
+// FNV-1a
+static uint64_t hashBytes(uint64_t h, const void* data, size_t size) {
+	const uint8_t* p = (const uint8_t*)data;
+	for (size_t i = 0; i < size; ++i) {
+		h ^= p[i];
+		h *= 0x100000001b3ull;
+	}
+	return h;
+}
+
+template<typename T>
+static uint64_t hashValue(uint64_t h, const T& v) {
+	return hashBytes(h, &v, sizeof(v));
+}
+
+uint64_t actionFingerprint() {
+	static const uint64_t fingerprint = []() {
+		uint64_t h = 0xcbf29ce484222325ull;
+		for (int i = 0; i < ACTION_ARRAY_COUNT; ++i) {
+			const Action& a = actions[i];
+			h = hashBytes(h, a.name, strlen(a.name));
+			h = hashValue(h, a.cp_cost);
+			h = hashValue(h, a.durability_cost);
+			h = hashValue(h, a.progress_efficiency);
+			h = hashValue(h, a.quality_efficiency);
+			h = hashValue(h, (int)a.flags);
+			h = hashValue(h, (int)a.effect);
+			h = hashValue(h, a.effect_charges);
+			h = hashValue(h, a.effect_stacks);
+		}
+		return h;
+	}();
+	return fingerprint;
+}
+
+uint64_t solutionCacheKey(const GameContext& ctx) {
+	uint64_t h = 0xcbf29ce484222325ull;
+	h = hashValue(h, SOLVER_VERSION);
+	h = hashValue(h, actionFingerprint());
+	h = hashValue(h, ctx.base_progress_increase);
+	h = hashValue(h, ctx.base_quality_increase);
+	h = hashValue(h, ctx.max_cp);
+	h = hashValue(h, ctx.target_progress);
+	h = hashValue(h, ctx.target_quality);
+	h = hashValue(h, ctx.max_durability);
+	return h;
+}
+
+static std::string entryPath(const char* dir, uint64_t key) {
+	char name[32];
+	snprintf(name, sizeof(name), "/%016llx.sol", (unsigned long long)key);
+	return std::string(dir) + name;
+}
+
+// Reads an entry and checks it was written by this solver version and action table
+static bool readEntry(const char* path, GameContext& ctx, CachedSolution& out) {
+	FILE* f = fopen(path, "rb");
+	if (!f) {
+		return false;
+	}
+	SolutionCacheHeader header;
+	uint8_t seq[256];
+	bool ok = fread(&header, sizeof(header), 1, f) == 1
+		&& !memcmp(header.magic, SOLUTION_CACHE_MAGIC, sizeof(header.magic))
+		&& header.version == SOLVER_VERSION
+		&& header.action_fingerprint == actionFingerprint()
+		&& header.n_actions <= sizeof(seq)
+		&& fread(seq, 1, header.n_actions, f) == header.n_actions;
+	fclose(f);
+	if (!ok) {
+		return false;
+	}
+
+	ctx = GameContext{
+		.base_progress_increase = header.base_progress_increase,
+		.base_quality_increase = header.base_quality_increase,
+		.max_cp = header.max_cp,
+		.target_progress = header.target_progress,
+		.target_quality = header.target_quality,
+		.max_durability = header.max_durability
+	};
+	if (header.key != solutionCacheKey(ctx)) {
+		return false;
+	}
+	out.actions.clear();
+	for (uint32_t i = 0; i < header.n_actions; ++i) {
+		if (seq[i] >= ACTION_COUNT) {
+			return false;
+		}
+		out.actions.push_back((ACTION)seq[i]);
+	}
+	out.progress = header.progress;
+	out.quality = header.quality;
+	out.durability = header.durability;
+	out.cp = header.cp;
+	out.n_iterations = header.n_iterations;
+	return true;
+}
+
+bool solutionCacheLoad(const char* dir, const GameContext& ctx, CachedSolution& out) {
+	GameContext stored;
+	return readEntry(entryPath(dir, solutionCacheKey(ctx)).c_str(), stored, out)
+		&& stored.base_progress_increase == ctx.base_progress_increase
+		&& stored.base_quality_increase == ctx.base_quality_increase
+		&& stored.max_cp == ctx.max_cp
+		&& stored.target_progress == ctx.target_progress
+		&& stored.target_quality == ctx.target_quality
+		&& stored.max_durability == ctx.max_durability;
+}
+
+static bool isBetter(const CachedSolution& a, const CachedSolution& b) {
+	return a.n_iterations > b.n_iterations || (a.n_iterations == b.n_iterations && a.quality > b.quality);
+}
+
+// Serializes writers of one entry across processes, so the comparison with the stored
+// entry and the rename happen as one step. Writers hold it for a few file operations,
+// an older lock file was left by a crashed process and is taken over
+struct EntryLock {
+	std::string path;
+	bool held = false;
+
+	EntryLock(const std::string& entry_path)
+		: path(entry_path + ".lock") {
+		for (int attempt = 0; attempt < 200; ++attempt) {
+			FILE* f = fopen(path.c_str(), "wx");
+			if (f) {
+				fclose(f);
+				held = true;
+				return;
+			}
+			std::error_code ec;
+			auto age = std::filesystem::file_time_type::clock::now() - std::filesystem::last_write_time(path, ec);
+			if (!ec && age > std::chrono::seconds(10)) {
+				remove(path.c_str());
+				continue;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	}
+	~EntryLock() {
+		if (held) {
+			remove(path.c_str());
+		}
+	}
+};
+
+bool solutionCacheStore(const char* dir, const GameContext& ctx, const CachedSolution& sol) {
+	if (sol.actions.size() > 256) {
+		return false;
+	}
+	std::error_code ec;
+	std::filesystem::create_directories(dir, ec);
+
+	uint64_t key = solutionCacheKey(ctx);
+	SolutionCacheHeader header = {
+		.version = SOLVER_VERSION,
+		.key = key,
+		.action_fingerprint = actionFingerprint(),
+		.base_progress_increase = ctx.base_progress_increase,
+		.base_quality_increase = ctx.base_quality_increase,
+		.max_cp = ctx.max_cp,
+		.target_progress = ctx.target_progress,
+		.target_quality = ctx.target_quality,
+		.max_durability = ctx.max_durability,
+		.progress = sol.progress,
+		.quality = sol.quality,
+		.durability = sol.durability,
+		.cp = sol.cp,
+		.n_iterations = sol.n_iterations,
+		.n_actions = (uint32_t)sol.actions.size()
+	};
+	memcpy(header.magic, SOLUTION_CACHE_MAGIC, sizeof(header.magic));
+	uint8_t seq[256];
+	for (size_t i = 0; i < sol.actions.size(); ++i) {
+		seq[i] = (uint8_t)sol.actions[i];
+	}
+
+	// Unique temporary name per writer, the rename is atomic so readers see either entry whole
+	std::string path = entryPath(dir, key);
+	EntryLock lock(path);
+	if (!lock.held) {
+		return false;
+	}
+	CachedSolution old;
+	if (solutionCacheLoad(dir, ctx, old) && !isBetter(sol, old)) {
+		return false;
+	}
+	char suffix[64];
+	snprintf(suffix, sizeof(suffix), ".%08x%08x.tmp", std::random_device{}(), (unsigned)std::hash<std::thread::id>{}(std::this_thread::get_id()));
+	std::string tmp_path = path + suffix;
+	FILE* f = fopen(tmp_path.c_str(), "wb");
+	if (!f) {
+		return false;
+	}
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1
+		&& fwrite(seq, 1, sol.actions.size(), f) == sol.actions.size();
+	ok = fclose(f) == 0 && ok;
+	if (ok) {
+		std::filesystem::rename(tmp_path, path, ec);
+		ok = !ec;
+	}
+	if (!ok) {
+		remove(tmp_path.c_str());
+	}
+	return ok;
+}
+
+bool loadSolutionIndex(const char* dir, SolutionIndex& index) {
+	index.entries.clear();
+	std::error_code ec;
+	for (auto it = std::filesystem::directory_iterator(dir, ec); !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+		if (it->path().extension() != ".sol") {
+			continue;
+		}
+		SolutionIndexEntry entry;
+		if (readEntry(it->path().string().c_str(), entry.ctx, entry.sol)) {
+			index.entries.push_back(entry);
+		}
+	}
+	return !ec;
+}
+
+// Relative difference in base increases needed for progress and quality, plus relative CP.
+// A different durability changes which macros even finish, so it weighs as much as everything else
+static float craftDistance(const GameContext& a, const GameContext& b) {
+	auto rel = [](float x, float y) { return std::fabs(x - y) / std::max(1.f, std::max(x, y)); };
+	float d = rel(a.target_progress / (float)a.base_progress_increase, b.target_progress / (float)b.base_progress_increase)
+		+ rel(a.target_quality / (float)a.base_quality_increase, b.target_quality / (float)b.base_quality_increase)
+		+ rel((float)a.max_cp, (float)b.max_cp);
+	if (a.max_durability != b.max_durability) {
+		d += 1.f;
+	}
+	return d;
+}
+
+std::vector<const SolutionIndexEntry*> findNearestSolutions(const SolutionIndex& index, const GameContext& ctx, int k) {
+	const float MAX_DISTANCE = .5f;
+	std::vector<std::pair<float, const SolutionIndexEntry*>> candidates;
+	for (const SolutionIndexEntry& e : index.entries) {
+		float d = craftDistance(ctx, e.ctx);
+		if (d <= MAX_DISTANCE) {
+			candidates.push_back({ d, &e });
+		}
+	}
+	int n = std::min(k, (int)candidates.size());
+	std::partial_sort(candidates.begin(), candidates.begin() + n, candidates.end(),
+		[](const auto& a, const auto& b) { return a.first < b.first; });
+
+	std::vector<const SolutionIndexEntry*> nearest;
+	for (int i = 0; i < n; ++i) {
+		nearest.push_back(candidates[i].second);
+	}
+	return nearest;
+}
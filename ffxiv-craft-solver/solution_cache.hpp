@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "action_enum.hpp"
+#include "game_config.hpp"
+
+
+// Bump whenever action behaviour, scoring or the search itself changes,
+// so entries produced by an older solver stop matching
+constexpr uint32_t SOLVER_VERSION = 1;
+
+struct CachedSolution {
+	std::vector<ACTION> actions;
+
+	// Final state the macro reached when it was stored
+	int progress;
+	int quality;
+	int durability;
+	int cp;
+
+	// Search budget that produced it, a bigger request isn't served a cheaper answer
+	int n_iterations;
+};
+
+// Hash of the action table data. Covers the table only, changes to the execute/is_executable
+// callbacks need a SOLVER_VERSION bump (and are caught by replaying entries anyway)
+uint64_t actionFingerprint();
+
+// Hash of the craft, SOLVER_VERSION and the action table, names the entry on disk
+uint64_t solutionCacheKey(const GameContext& ctx);
+
+// One small file per entry, written to a temporary name and renamed into place,
+// so any number of processes can read and fill the same directory.
+// Loading only checks the entry belongs to 'ctx'; replaying it is up to the caller
+bool solutionCacheLoad(const char* dir, const GameContext& ctx, CachedSolution& out);
+// Only replaces an entry from a smaller search budget, or the same budget and less quality.
+// False when the stored entry was kept
+bool solutionCacheStore(const char* dir, const GameContext& ctx, const CachedSolution& sol);
+
+
+struct SolutionIndexEntry {
+	GameContext ctx;
+	CachedSolution sol;
+};
+
+// In-memory snapshot of a cache directory, for finding macros of similar crafts
+struct SolutionIndex {
+	std::vector<SolutionIndexEntry> entries;
+};
+
+// Entries from another solver version or action table are skipped
+bool loadSolutionIndex(const char* dir, SolutionIndex& index);
+// Up to k entries closest to ctx, nearest first. Crafts are compared by how many base
+// increases their targets take, by CP and by durability; far-off ones are left out
+std::vector<const SolutionIndexEntry*> findNearestSolutions(const SolutionIndex& index, const GameContext& ctx, int k);
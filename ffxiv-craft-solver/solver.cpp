@@ -0,0 +1,2237 @@
+#include "solver.hpp"
+
+#include <assert.h>
+#include <stdio.h>
+#include <exception>
+#include <algorithm>
+#include <vector>
+#include <array>
+#include <set>
+#include <random>
+#include <cmath>
+#include <time.h>
+#include <string.h>
+#include <sstream>
+#include "timer.hpp"
+
+#include "action_weight_table.hpp"
+#include "telemetry.hpp"
+#include "profiler.hpp"
+#include "metrics.hpp"
+#include "solution_cache.hpp"
+#include "portfolio.hpp"
+
+
+// Search state of the solver bound to this thread, see SolverScope
+static thread_local SearchState* search = 0;
+
+void initGameState(const GameContext& cfg, GameState& state) {
+	state.parent = HGAME_STATE();
+
+	state.progress = 0;
+	state.quality = 0;
+	state.durability = cfg.max_durability;
+	state.cp = cfg.max_cp;
+
+	state.step = 0;
+	state.used_action_idx = -1;
+}
+
+bool canExecuteAction(const GameContext& ctx, const GameState& state, ACTION action_idx) {
+	const Action& action = actions[action_idx];
+
+	if (state.durability <= 0 || state.progress >= ctx.target_progress) {
+		return false;
+	}
+
+	assert(action.pfn_is_executable);
+	if (!action.pfn_is_executable(ctx, &state)) {
+		return false;
+	}
+	if (state.cp < action.cp_cost) {
+		return false;
+	}
+	return true;
+}
+
+void applyAction(const GameContext& ctx, GameState& state, ACTION action_idx, bool verbose) {
+	const Action& action = actions[action_idx];
+
+	float veneration_mul = state.effects[E_VENERATION].n_charges > 0 ? 0.5f : 0.f;
+	float muscle_memory_mul = state.effects[E_MUSCLE_MEMORY].n_charges > 0 ? 1.f : .0f;
+
+	float inner_quiet_mul = 1.0f + 0.1f * state.effects[E_INNER_QUIET].n_stacks;
+	float great_strides_mul = state.effects[E_GREAT_STRIDES].n_charges > 0 ? 1.f : .0f;
+	float innovation_mul = state.effects[E_INNOVATION].n_charges > 0 ? 1.5f : 1.f;
+
+	assert(action.pfn_on_execute);
+	ActionResult result = action.pfn_on_execute(ctx, action, &state);
+	int p = result.progress_increase 
+		+ result.progress_increase * veneration_mul 
+		+ result.progress_increase * muscle_memory_mul;
+	int q = result.quality_increase	* inner_quiet_mul * innovation_mul
+		+ result.quality_increase * inner_quiet_mul * great_strides_mul;
+		//+ result.quality_increase * inner_quiet_mul 
+		//+ result.quality_increase * great_strides_mul 
+		//+ result.quality_increase * innovation_mul;
+	state.progress += p;
+	state.quality += q;
+	/*if (state.progress > ctx.target_progress) {
+		state.progress = ctx.target_progress;
+	}
+	if (state.quality > ctx.target_quality) {
+		state.quality = ctx.target_quality;
+	}*/
+
+	if (result.progress_increase > 0) {
+		state.effects[E_MUSCLE_MEMORY].n_charges = 0;
+	}
+	if (result.quality_increase > 0) {
+		state.effects[E_GREAT_STRIDES].n_charges = 0;
+	}
+
+	if (state.effects[E_FINAL_APPRAISAL].n_charges > 0) {
+		if (state.progress >= ctx.target_progress) {
+			state.progress = ctx.target_progress - 1;
+			state.effects[E_FINAL_APPRAISAL].n_charges = 0;
+		}
+	}
+
+	int wasted_durability = 0;
+	if (action_idx == IMMACULATE_MEND) {
+		wasted_durability += (ctx.max_durability - 5) - -result.durability_decrease;
+	}
+	if (action_idx == MASTERS_MEND) {
+		wasted_durability += std::max(-result.durability_decrease, -result.durability_decrease - (ctx.max_durability - state.durability));
+	}
+	if (result.durability_decrease == 0 && state.effects[E_WASTE_NOT].n_charges > 0) {
+		wasted_durability += 5; // Can be 10, but only if the only alternative is GW or PT. 5 is more common
+	}
+	state.wasted_durability += wasted_durability;
+
+	int durability_decrease = 0;
+	if (result.durability_decrease < 0) {
+		state.durability = std::min(ctx.max_durability, state.durability - result.durability_decrease);
+	} else if(state.effects[E_TRAINED_PERFECTION].n_stacks > 0 && result.durability_decrease > 0) {
+		state.effects[E_TRAINED_PERFECTION].n_stacks--;
+	} else if(state.effects[E_WASTE_NOT].n_charges > 0) {
+		durability_decrease = result.durability_decrease / 2;
+	} else {
+		durability_decrease = result.durability_decrease;
+	}
+	state.durability -= durability_decrease;
+	state.cp -= result.cp_cost;
+
+	if (verbose) {
+		printf("%s [", actionToString(action_idx));
+		if (state.effects[E_INNER_QUIET].n_stacks) printf("IQ:%i", state.effects[E_INNER_QUIET].n_stacks);
+		printf("]\n");
+		if (q) printf("[->] Quality increases by %i\n", q);
+		if (p) printf("[->] Progress increases by %i\n", p);
+		if (durability_decrease) printf("[->] Durability decreases by %i\n", durability_decrease);
+		if (result.cp_cost) printf("[->] CP decreases by %i\n", result.cp_cost);
+	}
+
+	// TODO: Not sure if Delicate Synthesis (increases both p and q) should be counted in these
+	if (result.progress_increase > 0 && result.quality_increase == 0) {
+		state.cp_used_on_progress += result.cp_cost;
+		state.durability_used_on_progress += durability_decrease;
+	}
+	if (result.quality_increase > 0 && result.progress_increase == 0) {
+		state.cp_used_on_quality += result.cp_cost;
+		state.durability_used_on_quality += durability_decrease;
+	}
+
+	state.used_action_idx = action_idx;
+
+	if (state.durability <= 0) {
+		// If durability ran out - no effect handling
+		return;
+	}
+
+	// Apply 'manipulation' effect if present
+	// NOTE: Manipulation's effect is not applied if manipulation was used again this turn
+	if (state.effects[E_MANIPULATION].n_charges > 0 && action.effect != E_MANIPULATION) {
+		state.durability = std::min(ctx.max_durability, state.durability + 5);
+	}
+	// Decrease active effects' charges
+	if (action.effect != E_FINAL_APPRAISAL) {
+		for (int i = 0; i < EFFECT_COUNT; ++i) {
+			if (state.effects[i].n_charges > 0) {
+				state.effects[i].n_charges--;
+			}
+		}
+	}
+
+	// Add action's effect
+	if (action.effect != E_NONE) {
+		state.addEffect(action.effect, action.effect_charges, action.effect_stacks);
+	}
+
+	if (action.isTouch()) {
+		state.addInnerQuiet();
+	}
+}
+
+HGAME_STATE executeAction(const GameContext& ctx, HGAME_STATE hstate, ACTION action_idx, bool verbose) {
+	if (!canExecuteAction(ctx, *hstate, action_idx)) {
+		return HGAME_STATE();
+	}
+
+	HGAME_STATE new_state = createGameState(*hstate);
+	if (!new_state.isValid()) {
+		return HGAME_STATE();
+	}
+	++new_state->step;
+	new_state->parent = hstate;
+	applyAction(ctx, *new_state, action_idx, verbose);
+	return new_state;
+}
+
+
+
+void deleteBranchImpl(HGAME_STATE state, int& count) {
+	if (state->parent.isValid()) {
+		deleteBranchImpl(state->parent, count);
+	}
+	freeGameState(state);
+	++count;
+}
+
+void deleteBranch(HGAME_STATE state) {
+	int count = 0;
+	deleteBranchImpl(state, count);
+}
+
+HGAME_STATE copyBranchImpl(HGAME_STATE state, bool keep_score) {
+	if (!state.isValid()) {
+		return HGAME_STATE();
+	}
+	HGAME_STATE new_state = createGameState(*state, keep_score);
+	new_state->parent = copyBranchImpl(state->parent, keep_score);
+	return new_state;
+}
+
+HGAME_STATE copyBranch(HGAME_STATE state, bool keep_score) {
+	return copyBranchImpl(state, keep_score);
+}
+
+int makeSequenceImpl(HGAME_STATE state, ACTION* seq, int max_len) {
+	if (!state.isValid()) {
+		return 0;
+	}
+	if (!state->parent.isValid()) {
+		return 0;
+	}
+	int at = makeSequenceImpl(state->parent, seq, max_len);
+	if (at >= max_len) {
+		return at;
+	}
+	seq[at] = (ACTION)state->used_action_idx;
+	return at + 1;
+}
+int makeSequence(HGAME_STATE state, ACTION* seq, int max_len) {
+	int len = makeSequenceImpl(state, seq, max_len);
+	return len;
+}
+
+std::string formatMacro(const ACTION* seq, int len) {
+	std::string text;
+	char line[128];
+	for (int i = 0; i < len; ++i) {
+		if (i && i % 14 == 0) {
+			snprintf(line, sizeof(line), "/e Part %i complete <se.8>\n\n", i / 14 - 1);
+			text += line;
+		}
+		snprintf(line, sizeof(line), "/ac \"%s\" <wait.3>\n", actions[seq[i]].name);
+		text += line;
+	}
+	return text;
+}
+void printMacro(const HGAME_STATE state) {
+	if (!state.isValid()) {
+		printf("No successfull paths\n");
+		return;
+	}
+	ACTION seq[256];
+	int len = makeSequence(state, seq, 256);
+	printf("%s\n", formatMacro(seq, len).c_str());
+}
+
+void printActionArrayImpl(const HGAME_STATE state) {	
+	if (!state.isValid()) {
+		printf("No successfull paths");
+		return;
+	}
+	if (state->parent.isValid()) {
+		printActionArrayImpl(state->parent);
+	}
+	if (state->used_action_idx == -1) {
+		return;
+	}
+	printf("\t%s,\n", actionToString((ACTION)state->used_action_idx));
+}
+void printActionArray(const HGAME_STATE state) {
+	printf("ACTION seq[] = {\n");
+	printActionArrayImpl(state);
+	printf("};\n");
+}
+void printState(const GameContext& ctx, const GameState* state, int pool_idx) {
+	printf("[%i] step %i: [%s] p: %i/%i, q: %i/%i, d: %i/%i, cp: %i/%i,",
+		pool_idx,
+		state->step, actionToString((ACTION)state->used_action_idx),
+		state->progress, ctx.target_progress,
+		state->quality, ctx.target_quality,
+		state->durability, ctx.max_durability,
+		state->cp, ctx.max_cp
+	);
+	printf("\n\tvisits: %i, score: %.6Lf, max_score: %.6Lf, p/cp: %.3Lf, p/d: %.3Lf, wd: %i,",
+		state->n_visits,
+		state->score,
+		state->max_score,
+		state->progress / (long double)state->cp_used_on_progress,
+		state->progress / (long double)state->durability_used_on_progress,
+		state->wasted_durability
+	);
+	printf("\n\tq/cp: %.3Lf, q/d: %.3Lf\n",
+		state->quality / (long double)state->cp_used_on_quality,
+		state->quality / (long double)state->durability_used_on_quality
+	);
+}
+void printState(const GameContext& ctx, const HGAME_STATE state) {
+	if (!state.isValid()) {
+		printf("printState: invalid state handle\n");
+		return;
+	}
+	printState(ctx, state.deref(), state.getIdx());
+}
+
+void printProgressBar(int value, int total) {
+	float ratio = value / (float)total;
+	const int max_blocks = 50;
+	printf("[");
+	for (int i = 0; i < max_blocks; ++i) {
+		if (i / (float)max_blocks < ratio) {
+			printf("#");
+		} else {
+			printf(" ");
+		}
+	}
+	printf("] %i%%, %i/%i\n", (int)(ratio * 100), value, total);
+}
+
+void printElapsed(float sec) {
+	int minutes = (int)sec / 60;
+	float seconds = sec - minutes * 60;
+	
+	if (minutes) printf("%im ", minutes);
+	if (seconds) printf("%.3fs ", seconds);
+	printf("elapsed\n");
+}
+
+void printBranchCompactImpl(const HGAME_STATE state) {
+	if (!state.isValid()) {
+		return;
+	}
+	printBranchCompactImpl(state->parent);
+	printf("%i, ", state->combo_depth);
+}
+void printBranchCompact(const HGAME_STATE state) {
+	printBranchCompactImpl(state);
+	printf("\n");
+}
+
+void getBranchLengthImpl(const HGAME_STATE state, int& count) {
+	if (!state.isValid()) {
+		return;
+	}
+	getBranchLengthImpl(state->parent, count);
+	++count;
+}
+int getBranchLength(const HGAME_STATE state) {
+	int count = 0;
+	getBranchLengthImpl(state, count);
+	return count;
+}
+
+void fillTelemetryState(TelemetryEvent& e, const HGAME_STATE state, bool with_macro) {
+	e.pool_occupancy = getAllocatedStatesCount();
+	e.best_macro_id = search->best_macro_id;
+	e.best_score = (float)search->best_score;
+	if (!state.isValid()) {
+		return;
+	}
+	e.progress = state->progress;
+	e.quality = state->quality;
+	e.durability = state->durability;
+	e.cp = state->cp;
+	e.step = state->step;
+	if (with_macro) {
+		ACTION seq[TELEMETRY_MAX_MACRO_LEN];
+		int len = makeSequence(state, seq, TELEMETRY_MAX_MACRO_LEN);
+		for (int i = 0; i < len; ++i) {
+			e.macro[i] = (uint8_t)seq[i];
+		}
+		e.macro_len = (uint8_t)len;
+	}
+}
+
+// Search threads never print directly, everything goes through the telemetry ring
+void printLatest(const GameContext& ctx) {
+	++search->best_macro_id;
+	TelemetryEvent e = {};
+	e.type = TE_NEW_BEST;
+	e.iteration = search->search_iteration;
+	fillTelemetryState(e, search->last_deadend_state, true);
+	telemetryPush(e);
+
+	metricsRecordBest(search->best_score, search->last_deadend_state->quality, search->last_deadend_state->progress);
+}
+
+bool storeLatestDeadendScored(const GameContext& ctx, HGAME_STATE state) {
+	if (!search->last_deadend_state.isValid()) {
+		search->last_deadend_state = copyBranch(state);
+		printLatest(ctx);
+		return true;
+	}
+
+	float score = std::min(ctx.target_progress, state->progress) * 0.45f + state->quality * 0.55f + state->durability + state->cp;
+	float old_score = std::min(ctx.target_progress, search->last_deadend_state->progress) * 0.45f + search->last_deadend_state->quality * 0.55f + search->last_deadend_state->durability + search->last_deadend_state->cp;
+
+	if (score > old_score) {
+		deleteBranch(search->last_deadend_state);
+		search->last_deadend_state = copyBranch(state);
+		printLatest(ctx);
+		return true;
+	}
+	return false;
+}
+
+bool storeLatestDeadend(const GameContext& ctx, HGAME_STATE state) {
+	if (search->params && search->params->incumbent && state->progress >= ctx.target_progress) {
+		raiseIncumbent(*search->params->incumbent, state->quality);
+	}
+	if (!search->last_deadend_state.isValid()) {
+		search->last_deadend_state = copyBranch(state, true);
+		printLatest(ctx);
+		return true;
+	}
+
+	if (search->last_deadend_state->progress < ctx.target_progress) {
+		/*if (state->progress == search->last_deadend_state->progress && state->cp > search->last_deadend_state->cp) {
+			deleteBranch(search->last_deadend_state);
+			search->last_deadend_state = copyBranch(state);
+			printLatest(ctx);
+			return true;
+		}*/
+		if (state->progress > search->last_deadend_state->progress) {
+			deleteBranch(search->last_deadend_state);
+			search->last_deadend_state = copyBranch(state, true);
+			printLatest(ctx);
+			return true;
+		}
+		return false;
+	}
+
+	if (state->progress < ctx.target_progress) {
+		return false;
+	}
+	
+	//if (search->last_deadend_state->quality < ctx.target_quality) {
+		if (state->quality > search->last_deadend_state->quality) {
+			deleteBranch(search->last_deadend_state);
+			search->last_deadend_state = copyBranch(state, true);
+			printLatest(ctx);
+			return true;
+		}
+		else if (state->quality < search->last_deadend_state->quality) {
+			return false;
+		}
+	//}
+	/*
+	if (state->quality < ctx.target_quality) {
+		return false;
+	}*/
+	
+	if (state->step < search->last_deadend_state->step) {
+		deleteBranch(search->last_deadend_state);
+		search->last_deadend_state = copyBranch(state, true);
+		printLatest(ctx);
+		return true;
+	}
+
+	return false;
+}
+
+
+void findSolution(const GameContext& ctx, HGAME_STATE state, int max_step) {
+	if (state->durability <= 0) {
+		storeLatestDeadend(ctx, state);
+		freeGameState(state);
+		return;
+	}
+	if (state->progress >= ctx.target_progress) {
+		storeLatestDeadend(ctx, state);
+		freeGameState(state);
+		return;
+	}
+	
+	if (state->step == max_step) {
+		storeLatestDeadend(ctx, state);
+		freeGameState(state);
+		return;
+	}
+	
+	for (int i = 0; i < ACTION_COUNT; ++i) {
+		int action_idx = i;
+		auto new_state = executeAction(ctx, state, (ACTION)action_idx);
+		if (new_state.isValid()) {
+			new_state->used_action_idx = action_idx;
+			findSolution(ctx, new_state, max_step);
+		}
+	}
+	
+
+	freeGameState(state);
+}
+
+
+HGAME_STATE executeSequence(const GameContext& ctx, HGAME_STATE state, int max_step, const ACTION* seq, int seq_len, bool verbose) {
+	HGAME_STATE new_state = HGAME_STATE();
+
+	if (state->durability <= 0 || state->progress >= ctx.target_progress) {
+		return new_state;
+	}
+
+	for (int i = 0; i < seq_len; ++i) {
+		if (state->step >= max_step) {
+			break;
+		}
+
+		HGAME_STATE tmp_new_state = executeAction(ctx, state, seq[i], verbose);
+		if (!tmp_new_state.isValid()) {
+			break;
+		}
+		new_state = tmp_new_state;
+		new_state->combo_depth = i;
+		new_state->used_action_idx = seq[i];
+
+		if (new_state->durability <= 0) {
+			break;
+		}
+		if (new_state->progress >= ctx.target_progress) {
+			break;
+		}
+		state = new_state;
+	}
+
+	return new_state;
+}
+
+void assignActionWeightsFromTable(const GameContext& ctx, const GameState& state, float* weights) {
+	if (state.step == 0) {
+		std::fill(weights, weights + ACTION_COUNT, .0f);
+		weights[MUSCLE_MEMORY] = 1.f;
+		weights[REFLECT] = 1.f;
+		return;
+	}
+	for (int i = 0; i < ACTION_COUNT; ++i) {
+		weights[i] *= getActionWeight((ACTION)state.used_action_idx, (ACTION)i);
+	}
+}
+
+void assignActionWeightsManual(const GameContext& ctx, const GameState& state, float* weights) {	
+	/*
+		BASIC_SYNTHESIS,
+		BASIC_TOUCH,
+		MASTERS_MEND,
+		OBSERVE,
+		WASTE_NOT,
+		VENERATION,
+		STANDARD_TOUCH,
+		GREAT_STRIDES,
+		INNOVATION,
+		FINAL_APPRAISAL,
+		WASTE_NOT_II,
+		BYREGOTS_BLESSING,
+		MUSCLE_MEMORY,
+		CAREFUL_SYNTHESIS,
+		MANIPULATION,
+		PRUDENT_TOUCH,
+		ADVANCED_TOUCH,
+		REFLECT,
+		PREPARATORY_TOUCH,
+		GROUNDWORK,
+		DELICATE_SYNTHESIS,
+		PRUDENT_SYNTHESIS,
+		TRAINED_FINESSE,
+		REFINED_TOUCH,
+		IMMACULATE_MEND,
+		TRAINED_PERFECTION
+	*/
+	/*
+		E_INNER_QUIET = 0,
+		E_WASTE_NOT,
+		E_VENERATION,
+		E_GREAT_STRIDES,
+		E_INNOVATION,
+		E_FINAL_APPRAISAL,
+		E_MUSCLE_MEMORY,
+		E_MANIPULATION,
+		E_TRAINED_PERFECTION,
+	*/
+
+	if (state.step == 0) {
+		std::fill(weights, weights + ACTION_COUNT, .0f);
+		weights[MUSCLE_MEMORY] = 1.f;
+		weights[REFLECT] = 1.f;
+	}
+
+	float mm_cppd = actions[MASTERS_MEND].cp_cost / 30.L;
+	float im_cppd = actions[IMMACULATE_MEND].cp_cost / (float)(ctx.max_durability - 10);
+	if (mm_cppd < im_cppd) {
+		weights[IMMACULATE_MEND] *= .0f;
+	} else {
+		weights[MASTERS_MEND] *= .0f;
+	}
+
+	if (state.trained_perfection_charges > 0) {
+		weights[TRAINED_PERFECTION] *= 1.5f;
+	} else {
+		weights[TRAINED_PERFECTION] *= .0f;
+	}
+	//weights[BASIC_SYNTHESIS] *= 0.0f;
+
+	//if (state.progress < (ctx.target_progress - ctx.base_progress_increase * 3.0f)) {
+		weights[FINAL_APPRAISAL] *= .0f;
+	//}
+
+	if (state.used_action_idx == BASIC_TOUCH) {
+		weights[STANDARD_TOUCH] *= 2.f;
+		weights[BASIC_TOUCH] *= .0f;
+	}
+	if (state.used_action_idx == OBSERVE || state.used_action_idx == STANDARD_TOUCH) {
+		weights[ADVANCED_TOUCH] *= 2.f;
+		weights[STANDARD_TOUCH] *= .0f;
+		weights[OBSERVE] *= .0f;
+	}
+
+	if (ctx.max_durability - state.durability <= 30 || state.durability > 15) {
+		weights[IMMACULATE_MEND] *= .0f;
+	}
+	if (ctx.max_durability - state.durability < 30) {
+		weights[MASTERS_MEND] *= .0f;
+	}
+	
+	if (state.effects[E_WASTE_NOT].n_charges > 0) {
+		weights[WASTE_NOT] *= .0f;
+		weights[WASTE_NOT_II] *= .0f;
+	}
+
+	/*
+	if (state.effects[E_INNER_QUIET].n_stacks > 0) {
+		weights[BASIC_TOUCH] *= 1.5f;
+		weights[STANDARD_TOUCH] *= 1.5f;
+		weights[PRUDENT_TOUCH] *= 1.5f;
+		weights[ADVANCED_TOUCH] *= 1.5f;
+		weights[PREPARATORY_TOUCH] *= 1.5f;
+		weights[DELICATE_SYNTHESIS] *= 1.5f;
+		weights[TRAINED_FINESSE] *= 1.5f;
+		weights[REFINED_TOUCH] *= 1.5f;
+	}*/
+	if (state.effects[E_INNER_QUIET].n_stacks >= 10) {
+		weights[GREAT_STRIDES] *= 1.5f;
+		weights[BYREGOTS_BLESSING] *= 1.5f;
+	} else {
+		weights[BYREGOTS_BLESSING] *= .0f;
+	}
+	if (state.effects[E_VENERATION].n_charges > 0) {
+		weights[VENERATION] *= .0f;
+		weights[INNOVATION] *= .0f;
+
+		weights[GROUNDWORK] *= 1.5f;
+		weights[BASIC_SYNTHESIS] *= 1.5f;
+		weights[CAREFUL_SYNTHESIS] *= 1.5f;
+		weights[DELICATE_SYNTHESIS] *= 1.5f;
+		weights[PRUDENT_SYNTHESIS] *= 1.5f;
+	}
+	if (state.effects[E_GREAT_STRIDES].n_charges > 0) {
+		weights[BYREGOTS_BLESSING] *= 1.5f;
+	}
+	if (state.effects[E_INNOVATION].n_charges > 0) {
+		weights[INNOVATION] *= .0f;
+		weights[VENERATION] *= .0f;
+		
+		weights[BYREGOTS_BLESSING] *= 1.3f;
+		weights[BASIC_TOUCH] *= 1.5f;
+		weights[STANDARD_TOUCH] *= 1.5f;
+		weights[PRUDENT_TOUCH] *= 1.5f;
+		weights[ADVANCED_TOUCH] *= 1.5f;
+		weights[PREPARATORY_TOUCH] *= 1.5f;
+		weights[DELICATE_SYNTHESIS] *= 1.5f;
+		weights[PRUDENT_SYNTHESIS] *= 1.5f;
+		weights[TRAINED_FINESSE] *= 1.5f;
+		weights[REFINED_TOUCH] *= 1.5f;
+	}
+	if (state.effects[E_MUSCLE_MEMORY].n_charges > 0) {
+		weights[VENERATION] *= 1.5f;
+		weights[GROUNDWORK] *= 1.5f;
+	}
+	if (state.effects[E_TRAINED_PERFECTION].n_stacks > 0) {
+		weights[GROUNDWORK] *= 1.5f;
+		weights[PREPARATORY_TOUCH] *= 1.5f;
+	}
+	/*
+	for (int i = 0; i < ACTION_COUNT; ++i) {
+		weights[i] += 0.2f * ((rand() % 100) * 0.01f) - 0.1f;
+	}*/
+}
+
+void assignActionWeights(const GameContext& ctx, const GameState& state, float* weights) {
+	if (ctx.use_weight_table) {
+		assignActionWeightsFromTable(ctx, state, weights);
+	} else {
+		assignActionWeightsManual(ctx, state, weights);
+	}
+}
+
+void assignActionWeights(const GameContext& ctx, HGAME_STATE state, float* weights) {
+	assignActionWeights(ctx, *state, weights);
+}
+
+int selectRandomAction(const GameContext& ctx, HGAME_STATE state, float* weights) {
+	assignActionWeights(ctx, state, weights);
+
+	bool all_zero = true;
+	for (int i = 0; i < ACTION_COUNT; ++i) {
+		if (weights[i] > .0f) {
+			all_zero = false;
+			break;
+		}
+	}
+	if (all_zero) {
+		return -1;
+	}
+
+	std::discrete_distribution<int> distr(weights, weights + ACTION_COUNT);
+	int selected_action = distr(search->rng);
+
+	return selected_action;
+}
+
+int selectBestAction(const GameContext& ctx, HGAME_STATE state, float* weights) {
+	assignActionWeights(ctx, state, weights);
+
+	typedef std::pair<float, ACTION> pair_t;
+	pair_t sorted[ACTION_COUNT];
+	for (int i = 0; i < ACTION_COUNT; ++i) {
+		sorted[i].first = weights[i];
+		sorted[i].second = (ACTION)i;
+	}
+	std::sort(sorted, sorted + ACTION_COUNT, [](auto a, auto b)->bool { return a.first > b.first; });
+
+	if (sorted[0].first < FLT_EPSILON) {
+		return -1;
+	}
+	return sorted[0].second;
+}
+
+const EndgameTable* endgame_table = 0;
+
+// Oracle of the bound search, rebuilt whenever the craft changes
+static const ProgressOracle& progressOracle(const GameContext& ctx) {
+	if (!progressOracleMatches(search->progress_oracle, ctx)) {
+		buildProgressOracle(ctx, search->progress_oracle);
+	}
+	return search->progress_oracle;
+}
+
+// True if a portfolio engine already finished with more quality than 'state' can reach
+static bool belowSharedIncumbent(const GameContext& ctx, const GameState& state, int steps_left) {
+	return search->params && belowIncumbent(ctx, state, steps_left, search->params->incumbent);
+}
+
+HGAME_STATE finishFromEndgameTable(const GameContext& ctx, HGAME_STATE state, int max_step, int combo_depth) {
+	const EndgameEntry* e = endgame_table ? lookupEndgame(*endgame_table, ctx, *state) : 0;
+	if (!e || state->step + e->len > max_step) {
+		return HGAME_STATE();
+	}
+	HGAME_STATE head = state;
+	for (int i = 0; i < e->len; ++i) {
+		HGAME_STATE next = executeAction(ctx, head, (ACTION)e->actions[i]);
+		if (!next.isValid()) {
+			break;
+		}
+		next->combo_depth = combo_depth + i;
+		head = next;
+	}
+	if (head->progress >= ctx.target_progress) {
+		return head;
+	}
+	while (!(head == state)) {
+		HGAME_STATE parent = head->parent;
+		freeGameState(head);
+		head = parent;
+	}
+	return HGAME_STATE();
+}
+
+HGAME_STATE executeRandomSequence(const GameContext& ctx, HGAME_STATE state, int max_step, int max_seq, int& total_durability_spent) {
+	HGAME_STATE new_state = HGAME_STATE();
+
+	if (state->durability <= 0 || state->progress >= ctx.target_progress) {
+		return new_state;
+	}
+
+	const int MAX_SEQUENCE = max_seq;
+
+	for (int i = 0; i < MAX_SEQUENCE; ++i) {
+		if (state->step >= max_step) {
+			break;
+		}
+		if (state->durability <= 0) {
+			break;
+		}
+		if (state->progress >= ctx.target_progress) {
+			break;
+		}
+		// The rest of the rollout would score zero anyway
+		if (!canStillFinish(progressOracle(ctx), *state, max_step - state->step)
+			|| belowSharedIncumbent(ctx, *state, max_step - state->step)) {
+			PROFILE_COUNT(PC_HOPELESS_ROLLOUTS, 1);
+			break;
+		}
+		HGAME_STATE finished = finishFromEndgameTable(ctx, state, max_step, i);
+		if (finished.isValid()) {
+			PROFILE_COUNT(PC_ENDGAME_HITS, 1);
+			new_state = finished;
+			break;
+		}
+
+		int action_idx = -1;
+		float weights[ACTION_COUNT];
+		std::fill(weights, weights + ACTION_COUNT, 1.f);
+		
+		for (int j = 0; j < ACTION_COUNT; ++j) {
+			const Action& action = actions[j];
+			HGAME_STATE st = executeAction(ctx, state, (ACTION)j);
+			if (!st.isValid()) {
+				weights[j] = .0f;
+				continue;
+			}/*
+			if (st->durability <= 0 && st->progress < ctx.target_progress) {
+				weights[j] = .0f;
+			}*/
+			freeGameState(st);/*
+			if (state->cp < action.cp_cost) {
+				continue;
+			}*/
+		}
+		PROFILE_COUNT(PC_ROLLOUT_PROBES, ACTION_COUNT);
+
+		action_idx = selectRandomAction(ctx, state, weights);
+		if (action_idx == -1) {
+			break;
+		}
+		
+
+		HGAME_STATE tmp_new_state = executeAction(ctx, state, (ACTION)action_idx);
+		if (!tmp_new_state.isValid()) {
+			break;
+		}
+		new_state = tmp_new_state;
+		new_state->combo_depth = i;
+		new_state->used_action_idx = action_idx;
+
+		if (state->durability > new_state->durability) {
+			total_durability_spent += state->durability - new_state->durability;
+		}
+
+		//state->children.push_back(new_state);
+		state->actions_expanded |= 1u << action_idx;
+		state = new_state;
+	}
+
+	return new_state;
+}
+
+HGAME_STATE freeComboBranchImpl(HGAME_STATE state, int depth, int& count) {
+	if (!state.isValid()) {
+		return HGAME_STATE();
+	}
+	if (depth != state->combo_depth) {
+		return state;
+	}
+
+	HGAME_STATE new_head = freeComboBranchImpl(state->parent, depth - 1, count);
+	
+	freeGameState(state);
+	++count;
+	return new_head;
+}
+HGAME_STATE freeComboBranch(HGAME_STATE state) {
+	int count = 0;
+	HGAME_STATE new_head = freeComboBranchImpl(state, state->combo_depth, count);
+	return new_head;
+}
+
+void findSolutionWithCombos(const GameContext& ctx, HGAME_STATE state, int max_step) {
+	if (state->durability <= 0) {
+		storeLatestDeadend(ctx, state);
+		freeComboBranch(state);
+		return;
+	}
+	if (state->progress >= ctx.target_progress) {
+		storeLatestDeadend(ctx, state);
+		freeComboBranch(state);
+		return;
+	}
+
+	if (state->step == max_step) {
+		storeLatestDeadend(ctx, state);
+		freeComboBranch(state);
+		return;
+	}
+	if (!canStillFinish(progressOracle(ctx), *state, max_step - state->step)) {
+		freeComboBranch(state);
+		return;
+	}
+
+	for (int i = 0; i < COMBO_COUNT; ++i) {
+		auto new_state = executeSequence(ctx, state, max_step, combos[i].data(), combos[i].size());
+		if (new_state.isValid()) {
+			findSolutionWithCombos(ctx, new_state, max_step);
+			//freeComboBranch(new_state);
+		}
+	}
+
+	freeComboBranch(state);
+}
+
+void removeFromSequence(ACTION* seq, int len, int remove_at) {
+	if (remove_at == len - 1) {
+		// TODO: ???
+		return;
+	}
+	for (int i = remove_at; i < len; ++i) {
+		seq[i] = seq[i + 1];
+	}
+}
+
+void fillRandomSequence(ACTION* seq, int len) {
+	std::uniform_int_distribution<int> dist(0, ACTION_COUNT - 1);
+	for (int i = 0; i < len; ++i) {
+		int action_idx = dist(search->rng);
+		seq[i] = (ACTION)action_idx;
+	}
+}
+
+void fillRandomSequence2(const GameContext& ctx, const HGAME_STATE state, ACTION* seq, int len) {
+	std::uniform_int_distribution<int> dist(0, ACTION_COUNT - 1);
+
+	EFFECT effects_[EFFECT_COUNT];
+	memcpy(effects_, state->effects, std::min(sizeof(effects_), sizeof(state->effects)));
+
+	for (int i = 0; i < len; ++i) {
+		int action_idx = dist(search->rng);
+		seq[i] = (ACTION)action_idx;
+	}
+}
+
+void propagateScoreImpl(const GameContext& ctx, HGAME_STATE state, long double eval, long double max_score, int visits) {
+	if (state->parent.isValid()) {
+		propagateScoreImpl(ctx, state->parent, eval, max_score, visits);
+	}
+	state->score += eval;
+	state->max_score = std::max(state->max_score, max_score);
+	state->sum_of_squared_score += std::powl(eval, 2.L);
+	state->n_visits += visits;
+
+	if (ctx.write_weight_table && state->parent.isValid()) {
+		ACTION prev = (ACTION)state->parent->used_action_idx;
+		ACTION a = (ACTION)state->used_action_idx;
+		float w = getActionWeight(prev, a);
+		setActionWeight(prev, a, std::max(w, (float)state->max_score));
+	}
+}
+void propagateScore(const GameContext& ctx, HGAME_STATE state, long double eval, long double max_score, int visits) {
+	if (state->parent.isValid()) {
+		propagateScoreImpl(ctx, state->parent, eval, max_score, visits);
+	}
+	state->score = eval;
+	state->max_score = std::max(state->max_score, max_score);
+	state->sum_of_squared_score += std::powl(eval, 2.L);
+	state->n_visits += visits;
+
+	if (ctx.write_weight_table && state->parent.isValid()) {
+		ACTION prev = (ACTION)state->parent->used_action_idx;
+		ACTION a = (ACTION)state->used_action_idx;
+		float w = getActionWeight(prev, a);
+		setActionWeight(prev, a, std::max(w, (float)state->max_score));
+	}
+}
+
+void monteCarloSearch(const GameContext& ctx, HGAME_STATE state, int depth) {
+	std::vector<HGAME_STATE> children;
+
+	for (int i = 0; i < ACTION_COUNT; ++i) {
+		if (i == FINAL_APPRAISAL || i == OBSERVE) {
+			continue;
+		}
+		HGAME_STATE child = executeAction(ctx, state, (ACTION)i);
+		if (child.isValid()) {
+			children.push_back(child);
+		}
+	}
+
+
+	const int MAX_SEQ_LEN = 36;
+	ACTION seq[MAX_SEQ_LEN];
+	int ACTUAL_MAX_SEQ_LEN = MAX_SEQ_LEN - depth;
+	long double depth_ratio = ACTUAL_MAX_SEQ_LEN / (long double)MAX_SEQ_LEN;
+	long double depth_ratio2 = depth_ratio * depth_ratio;
+
+	const int MAX_ITERATIONS = 15'000;
+	const int N_ITERATIONS = MAX_ITERATIONS * (ACTUAL_MAX_SEQ_LEN / (long double)MAX_SEQ_LEN);
+
+	for (int i = 0; i < children.size(); ++i) {
+		long double total_score = .0;
+
+		for (int j = 0; j < N_ITERATIONS; ++j) {
+			fillRandomSequence(seq, ACTUAL_MAX_SEQ_LEN);
+			HGAME_STATE head = executeSequence(ctx, children[i], ACTUAL_MAX_SEQ_LEN, seq, ACTUAL_MAX_SEQ_LEN);
+			int tds = 0;
+			//HGAME_STATE head = executeRandomSequence(ctx, children[i], std::min(state->step + 6, MAX_SEQ_LEN), tds);
+			if (!head.isValid()) {
+				total_score -= 1000.L;
+				//total_score *= .5L;
+				continue;
+			}
+			
+			//if (head->progress >= ctx.target_progress) {
+				//long double q = head->quality;
+				//total_eval = total_eval + q * std::min(1.0L, std::max(0.2L * depth_ratio2, head->progress / (long double)ctx.target_progress));
+				long double dq = std::min(ctx.target_quality, head->quality) - state->quality;
+				long double dp = std::min(ctx.target_progress, head->progress) - state->progress;
+				long double dcp = state->cp - head->cp;
+				long double ds = head->step - state->step;
+				if (tds == 0) {
+					tds = 1;
+				}
+				if (dcp) {
+					dcp = ctx.max_cp;
+				}
+				
+				total_score += (dq + dp) / tds + (dq + dp) / (dcp * .1f);
+				//total_score += ((dq + dp) - tds - ds) * (1.L / ds);// - dcp * 1.L;
+				//total_score *= .5L;
+				/*if (dcp > .0) {
+					total_eval += (dq + dp) - dcp * 1.L;
+				}*/
+			//}
+			freeComboBranch(head);
+		}
+		//children[i]->evaluation = total_eval;
+		propagateScore(ctx, children[i], total_score, total_score, 0);
+	}
+
+	std::sort(children.begin(), children.end(), [](const HGAME_STATE& l, const HGAME_STATE& r)->bool{
+		return l->score > r->score;
+	});
+	const int MAX_CHILDREN = 1;
+	for (int i = MAX_CHILDREN; i < children.size(); ++i) {
+		freeGameState(children[i]);
+	}
+	children.resize(std::min(MAX_CHILDREN, (int)children.size()));
+	for (HGAME_STATE ch : children) {
+		appendChild(state, ch);
+	}
+
+	if (time(0) - search->last_branch_report > 1) {
+		search->last_branch_report = time(0);
+		for (int i = 0; i < std::min(MAX_CHILDREN, (int)children.size()); ++i) {
+			TelemetryEvent e = {};
+			e.type = TE_BRANCH;
+			e.iteration = depth;
+			fillTelemetryState(e, children[i], true);
+			telemetryPush(e);
+		}
+
+		for (int i = 0; i < std::min(MAX_CHILDREN, (int)children.size()); ++i) {
+			monteCarloSearch(ctx, children[i], depth + 1);
+		}
+	}
+	/*
+	if (children.empty()) {
+		// TODO:
+		return;
+	}
+	printMacro(children[0]);
+	printf("==========\n");
+	
+	monteCarloSearch(ctx, children[0], depth + 1);*/
+}
+
+long double calcUCT(HGAME_STATE parent, HGAME_STATE child, long double in_explore_constant, float max_score_weight_, int depth, int max_depth, long double rave_k = .0L) {
+	//long double score = child->wins;
+	//long double win_ratio = score / (child->wins + child->losses);
+	long double max_score_weight = max_score_weight_;
+	long double depth_ratio = std::min(1.0L, 1.0L - depth / (long double)max_depth);
+	long double C = 1.0L * in_explore_constant;
+	long double average_score = child->score / (long double)child->n_visits;
+	long double max_score = child->max_score;
+	long double exploitation = max_score * max_score_weight + average_score * (1.0L - max_score_weight);
+	if (rave_k > .0L && child->amaf_visits > 0) {
+		long double beta = std::sqrtl(rave_k / (3.0L * child->n_visits + rave_k));
+		exploitation = (1.0L - beta) * exploitation + beta * (child->amaf_score / child->amaf_visits);
+	}
+	long double NUM = std::log(parent->n_visits);
+	long double DENOM = (long double)child->n_visits;
+	long double exploration = C * std::sqrtl(NUM / DENOM);
+	long double UCT = exploitation + exploration;
+
+	// single player term
+	long double D = 1000.0L;
+	long double SP = std::sqrtl((child->sum_of_squared_score - child->n_visits * std::powl(max_score, 2.L) + D) / (child->n_visits));
+
+	//long double UCT = (child->max_score) + (.0L * std::sqrtl(std::log(parent->n_visits) / (long double)child->n_visits));
+	return UCT;// + SP;
+}
+
+HGAME_STATE monteCarloSelect(const GameContext& ctx, HGAME_STATE state, int max_depth, float explore_constant, float max_score_weight, int depth = 0) {
+	if (depth > 50) {
+		printf("! SELECT IS TOO DEEP: %i\n", depth);
+		printState(ctx, state->parent);
+		printState(ctx, state);
+	}
+
+	++state->n_visits;
+
+	if (!state->first_child.isValid()) {
+		return state;
+	}
+	if (state->n_possible_moves > 0) {
+		return state;
+	}
+
+	//long double depth_mul = std::max(0.0L, (1.0L - depth / 25.0L));
+	float C = explore_constant;// * (0.2f + 0.8f * (1.0f - depth / (float)max_depth));
+	HGAME_STATE result = state->first_child;
+	for (int i = rand() % state->n_children; i > 0; --i) {
+		result = result->next_sibling;
+	}
+	long double max_uct = calcUCT(state, result, C, max_score_weight, depth, max_depth);
+	for (HGAME_STATE ch = state->first_child; ch.isValid(); ch = ch->next_sibling) {
+		long double UCT = calcUCT(state, ch, C, max_score_weight, depth, max_depth);
+		if (UCT >= max_uct) {
+			max_uct = UCT;
+			result = ch;
+		}
+	}
+	if (result.isValid()) {
+		return monteCarloSelect(ctx, result, max_depth, explore_constant, max_score_weight, depth + 1);
+	}
+	return result;
+}
+
+HGAME_STATE monteCarloSelect2(const GameContext& ctx, HGAME_STATE state, int max_depth, float explore_constant, float max_score_weight, int depth = 0) {
+	++state->n_visits;
+
+	if (!state->first_child.isValid() && state->n_possible_moves == 0) {
+		if (state->progress < ctx.target_progress) {
+			return HGAME_STATE();
+		}
+		if(state->progress >= ctx.target_progress
+			&& search->last_deadend_state.isValid()
+			&& search->last_deadend_state->progress >= ctx.target_progress
+			&& state->quality < search->last_deadend_state->quality
+		) {
+			return HGAME_STATE();
+		}
+	}
+
+	if (!state->first_child.isValid()) {
+		return state;
+	}
+	if (state->n_possible_moves > 0) {
+		return state;
+	}
+
+	float C_bonus = .0f;//.4f * std::min(1.f, (1.f - depth / ((float)max_depth * .5f)));
+	float C = explore_constant * (1.f + C_bonus);
+	typedef std::pair<float, HGAME_STATE> pair_t;
+	std::vector<pair_t> sorted;
+	sorted.reserve(state->n_children);
+	for (HGAME_STATE ch = state->first_child; ch.isValid(); ch = ch->next_sibling) {
+		sorted.emplace_back(calcUCT(state, ch, C, max_score_weight, depth, max_depth, search->rave_equivalence), ch);
+	}
+	std::sort(sorted.begin(), sorted.end(), [](auto a, auto b)->bool { return a.first > b.first; });;
+
+	for (int i = 0; i < sorted.size(); ++i) {
+		float uct = sorted[i].first;
+		auto ch = sorted[i].second;
+		HGAME_STATE selected = monteCarloSelect2(ctx, ch, max_depth, C, max_score_weight, depth + 1);
+		if (selected.isValid()) {
+			return selected;
+		}
+
+		removeChild(state, ch);
+		metricsForgetNode(ch->step);
+		freeGameState(ch);
+		++search->n_deleted_states;
+	}
+
+	return HGAME_STATE();
+}
+
+long double monteCarloScore(const GameContext& ctx, const GameState& state) {
+	long double mm_cppd = actions[MASTERS_MEND].cp_cost / 30.L;
+	long double im_cppd = actions[IMMACULATE_MEND].cp_cost / (long double)(ctx.max_durability - 10);
+	long double durability_effective_cp_value = std::min(mm_cppd, im_cppd);
+	long double durability_as_cp_used_on_progress
+		= durability_effective_cp_value * (state.durability_used_on_progress);
+	long double durability_as_cp_used_on_quality
+		= durability_effective_cp_value * (state.durability_used_on_quality);
+
+	long double total_cp_used_on_progress = state.cp_used_on_progress + durability_as_cp_used_on_progress;
+	int capped_progress = std::min(ctx.target_progress, state.progress);
+	long double worst_progress_per_cp = ctx.target_progress / (long double)ctx.max_cp;
+	long double progress_per_cp = total_cp_used_on_progress == 0 ? .0L : capped_progress / total_cp_used_on_progress;
+	long double ppcp_ratio = progress_per_cp / worst_progress_per_cp;
+
+	long double total_cp_used_on_quality = state.cp_used_on_quality + durability_as_cp_used_on_quality;
+	long double worst_quality_per_cp = ctx.target_quality / (long double)ctx.max_cp;
+	long double quality_per_cp = total_cp_used_on_quality = 0 ? .0L : state.quality / total_cp_used_on_quality;
+	long double qpcp_ratio = quality_per_cp / worst_quality_per_cp;
+
+	int wasted_progress = std::max(0, state.progress - ctx.target_progress);
+	long double wp_ratio = 1.0L - wasted_progress / (ctx.base_progress_increase * actions[GROUNDWORK].progress_efficiency);
+
+	long double p_score = 0.45L * std::min(1.0L, state.progress / (long double)ctx.target_progress);
+	long double q_score = std::min(1.0L, state.quality / (long double)ctx.target_quality);
+	long double q_mul = 1.0L + 2.0L * std::min(1.0L, state.quality / (long double)ctx.target_quality);
+	long double cp_score = 0.05L * std::min(1.0L, 1.0L - state.cp / (long double)ctx.max_cp);
+	long double d_score = 0.05L * std::min(1.0L, state.durability / (long double)ctx.max_durability);
+	long double finish_bonus = state.progress >= ctx.target_progress ? 1.0L : .0L;
+	//long double score = (p_score + q_score + d_score + cp_score);
+	long double score = (q_score * q_score * ppcp_ratio) * finish_bonus;// *q_mul;
+
+	/*
+	long double p_score = 0.40L * std::min(1.0L, state.progress / (long double)ctx.target_progress);
+	long double q_score = 0.50L * std::min(1.0L, state.quality / (long double)ctx.target_quality);
+	long double cp_score = 0.05L * std::min(1.0L, state.cp / (long double)ctx.max_cp);
+	long double d_score = 0.05L * std::min(1.0L, state.durability / (long double)ctx.max_durability);
+	long double score = p_score + q_score + cp_score + d_score;*/
+	return score;
+}
+
+long double monteCarloScore(const GameContext& ctx, HGAME_STATE state) {
+	return monteCarloScore(ctx, *state);
+}
+
+void insertComboBranchAsChildren(HGAME_STATE head) {
+	if (!head->parent.isValid()) {
+		return;
+	}
+
+	appendChild(head->parent, head);
+	head->parent->actions_expanded |= 1u << head->used_action_idx;
+	metricsRecordNode(head->step);
+
+	if (head->parent->combo_depth < head->combo_depth) {
+		insertComboBranchAsChildren(head->parent);
+	}
+}
+
+// Credits 'score' to every child, along the path from 'head' up, whose action the playout
+// took at that point or any later one
+static void propagateAmaf(HGAME_STATE head, long double score) {
+	static_assert(ACTION_COUNT <= 32, "played mask is too narrow");
+	uint32_t played = 0;
+	for (HGAME_STATE node = head; node->parent.isValid(); node = node->parent) {
+		played |= 1u << node->used_action_idx;
+		for (HGAME_STATE ch = node->parent->first_child; ch.isValid(); ch = ch->next_sibling) {
+			if (played & (1u << ch->used_action_idx)) {
+				ch->amaf_score += score;
+				++ch->amaf_visits;
+			}
+		}
+	}
+}
+
+void monteCarloSimulate(const GameContext& ctx, HGAME_STATE state, int max_steps) {
+	const int MAX_STEPS = max_steps;
+	const int SEQ_ARRAY_LEN = 50;
+	ACTION seq[SEQ_ARRAY_LEN];
+	int MAX_SEQ_LEN = MAX_STEPS;// -state->step;
+	const int MAX_ITERATIONS = 1;
+	const int N_ITERATIONS = 1;// MAX_ITERATIONS* std::min(1.0L, 0.2L + (MAX_SEQ_LEN / (long double)MAX_STEPS));
+
+	long double total_score = .0;
+	long double max_score = .0;
+
+	for (int j = 0; j < N_ITERATIONS; ++j) {
+		int tds = 0;
+		//fillRandomSequence(seq, MAX_SEQ_LEN);
+		//fillRandomSequence2(ctx, state, seq, MAX_SEQ_LEN);
+		//HGAME_STATE head = executeSequence(ctx, state, MAX_STEPS, seq, MAX_SEQ_LEN);
+		HGAME_STATE head;
+		{
+			PROFILE_SCOPE(PP_SIMULATE);
+			head = executeRandomSequence(ctx, state, MAX_STEPS, MAX_SEQ_LEN, tds);
+		}
+		if (!head.isValid()) {
+			//total_score -= 1000.L;
+			//total_score *= .5L;
+			continue;
+		}
+		PROFILE_COUNT(PC_ROLLOUT_LENGTH, head->step - state->step);
+		
+		long double score = monteCarloScore(ctx, head);
+
+		if (search->best_score < score) {
+			search->best_score = score;
+		}
+
+		if(head->progress >= ctx.target_progress) {
+			storeLatestDeadend(ctx, head);
+		}
+		total_score += score;
+		if (score > max_score) {
+			max_score = score;
+		}
+		
+		{
+			PROFILE_SCOPE(PP_BACKPROP);
+			propagateScore(ctx, head, total_score, max_score, 0);
+		}
+		PROFILE_COUNT(PC_BACKPROP_LENGTH, head->step + 1);
+		state->n_visits++;
+
+		++search->total_playouts;
+		insertComboBranchAsChildren(head);
+		if (search->rave_equivalence > .0f) {
+			PROFILE_SCOPE(PP_BACKPROP);
+			propagateAmaf(head, score);
+		}
+		//freeComboBranch(head);
+	}
+}
+
+bool monteCarloExpandAndSimulate(const GameContext& ctx, HGAME_STATE state, int max_steps) {
+	bool any_expansions = false;
+	for (int i = 0; i < ACTION_COUNT; ++i) {
+		/*if (i == FINAL_APPRAISAL || i == OBSERVE) {
+			continue;
+		}
+		if (i == WASTE_NOT || i == WASTE_NOT_II && state->effects[E_WASTE_NOT].n_charges > 1) {
+			continue;
+		}
+		if (i == VENERATION && state->effects[E_VENERATION].n_charges > 1) {
+			continue;
+		}
+		if (i == INNOVATION && state->effects[E_INNOVATION].n_charges > 1) {
+			continue;
+		}
+		if (i == MANIPULATION && state->effects[E_MANIPULATION].n_charges > 1) {
+			continue;
+		}
+		if (i == BYREGOTS_BLESSING && state->effects[E_GREAT_STRIDES].n_charges == 0) {
+			continue;
+		}*/
+		HGAME_STATE child = executeAction(ctx, state, (ACTION)i);
+		if (child.isValid()) {
+			any_expansions = true;
+			appendChild(state, child);
+			monteCarloSimulate(ctx, child, max_steps);
+		}
+	}
+	return any_expansions;
+}
+// Adds the first learned combo starting with 'first' not tried from 'state' yet that plays out in
+// full and leaves the craft finishable, as a chain whose inner steps never branch, and simulates
+// from its end. False once every such combo was tried
+static bool monteCarloExpandCombo(const GameContext& ctx, HGAME_STATE state, int max_steps, ACTION first) {
+	const ComboSet& set = *search->combos;
+	const ProgressOracle& oracle = progressOracle(ctx);
+	GameState probe;
+	for (int k = 0; k < (int)set.combos.size(); ++k) {
+		const std::vector<ACTION>& seq = set.combos[k].actions;
+		if (seq[0] != first || (state->combos_expanded & (1u << k))) {
+			continue;
+		}
+		state->combos_expanded |= 1u << k;
+		const int len = (int)seq.size();
+		if (state->step + len > max_steps) {
+			continue;
+		}
+
+		// On the stack first, most combos don't fit most states
+		probe.inheritState(*state);
+		bool playable = true;
+		for (int i = 0; i < len && playable; ++i) {
+			if (!canExecuteAction(ctx, probe, seq[i])) {
+				playable = false;
+				break;
+			}
+			++probe.step;
+			applyAction(ctx, probe, seq[i]);
+			// Ending the craft part way is left to the primitive actions
+			if (i + 1 < len && (probe.durability <= 0 || probe.progress >= ctx.target_progress)) {
+				playable = false;
+			}
+		}
+		if (!playable || (probe.durability <= 0 && probe.progress < ctx.target_progress)) {
+			continue;
+		}
+		if (probe.progress < ctx.target_progress
+			&& (!canStillFinish(oracle, probe, max_steps - probe.step) || belowSharedIncumbent(ctx, probe, max_steps - probe.step))) {
+			continue;
+		}
+
+		HGAME_STATE tail = executeSequence(ctx, state, max_steps, seq.data(), len);
+		if (!tail.isValid()) {
+			return false;
+		}
+		for (HGAME_STATE node = tail; node->step > state->step; node = node->parent) {
+			node->combo_depth = 999999;
+			appendChild(node->parent, node);
+			if (node->parent->step > state->step) {
+				node->parent->in_combo = true;
+				node->parent->n_possible_moves = 0;
+			}
+			metricsRecordNode(node->step);
+		}
+		if (tail->progress >= ctx.target_progress) {
+			storeLatestDeadend(ctx, tail);
+		}
+		monteCarloSimulate(ctx, tail, max_steps);
+		return true;
+	}
+	return false;
+}
+
+// Children reached by a single action, combo edges aside
+static int primitiveChildren(HGAME_STATE state) {
+	int n = 0;
+	for (HGAME_STATE ch = state->first_child; ch.isValid(); ch = ch->next_sibling) {
+		n += ch->in_combo ? 0 : 1;
+	}
+	return n;
+}
+
+bool monteCarloExpandAndSimulate2(const GameContext& ctx, HGAME_STATE state, int max_steps) {
+	float weights[ACTION_COUNT];
+	std::fill(weights, weights + ACTION_COUNT, 1.f);
+
+	if (state->step >= max_steps) {
+		state->n_possible_moves = 0;
+		return false;
+	}
+
+	int action_idx = -1;
+	{
+		PROFILE_SCOPE(PP_EXPAND);
+		const ProgressOracle& oracle = progressOracle(ctx);
+		int n_probes = 0;
+		for (int j = 0; j < ACTION_COUNT; ++j) {
+			const Action& action = actions[j];
+			if (state->actions_expanded & (1u << j)) {
+				weights[j] = .0f;
+				continue;
+			}
+			++n_probes;
+			HGAME_STATE st = executeAction(ctx, state, (ACTION)j);
+			if (!st.isValid()) {
+				weights[j] = .0f;
+				continue;
+			}
+			if (st->durability <= 0 && st->progress < ctx.target_progress) {
+				weights[j] = .0f;
+			}
+			if (!canStillFinish(oracle, *st, max_steps - st->step) || belowSharedIncumbent(ctx, *st, max_steps - st->step)) {
+				weights[j] = .0f;
+			}
+			freeGameState(st);
+		}
+		PROFILE_COUNT(PC_EXPAND_PROBES, n_probes);
+
+		action_idx = selectBestAction(ctx, state, weights);
+	}
+	if (action_idx == -1) {
+		state->n_possible_moves = 0;
+		return false;
+	}
+
+	int possible_moves = 0;
+	for (int i = 0; i < ACTION_COUNT; ++i) {
+		if (weights[i] > .0f) {
+			++possible_moves;
+		}
+	}
+
+	int n_children = primitiveChildren(state);
+	if (possible_moves - n_children <= 0) {
+		assert(possible_moves - n_children == 0);
+		state->n_possible_moves = 0;
+		return false;
+	}
+
+	// Combos go ahead of their first action, so they follow the heuristic's order
+	if (search->combos && monteCarloExpandCombo(ctx, state, max_steps, (ACTION)action_idx)) {
+		return true;
+	}
+
+	HGAME_STATE child = executeAction(ctx, state, (ACTION)action_idx);
+	if (child.isValid()) {
+		appendChild(state, child);
+		state->actions_expanded |= 1u << action_idx;
+		metricsRecordNode(child->step);
+		possible_moves -= n_children + 1;
+		state->n_possible_moves = possible_moves;
+		if (child->progress >= ctx.target_progress) {
+			storeLatestDeadend(ctx, child);
+		}
+		monteCarloSimulate(ctx, child, max_steps);
+		return true;
+	}
+
+	state->actions_expanded |= 1u << action_idx;
+	possible_moves -= n_children;
+	state->n_possible_moves = possible_moves;
+	return false;
+}
+
+bool seedSequence(const GameContext& ctx, HGAME_STATE root, const ACTION* seq, int len, int max_steps, int prior_visits) {
+	HGAME_STATE node = root;
+	for (int i = 0; i < len && node->step < max_steps; ++i) {
+		if (node->durability <= 0 || node->progress >= ctx.target_progress) {
+			break;
+		}
+		HGAME_STATE next;
+		for (HGAME_STATE ch = node->first_child; ch.isValid(); ch = ch->next_sibling) {
+			if (ch->used_action_idx == seq[i] && !ch->in_combo) {
+				next = ch;
+				break;
+			}
+		}
+		if (!next.isValid()) {
+			next = executeAction(ctx, node, seq[i]);
+			if (!next.isValid()) {
+				break;
+			}
+			appendChild(node, next);
+			node->actions_expanded |= 1u << seq[i];
+			metricsRecordNode(next->step);
+		}
+		node = next;
+	}
+	if (node == root) {
+		return false;
+	}
+
+	// Near miss, finish it the way a fresh expansion gets simulated
+	if (node->durability > 0 && node->progress < ctx.target_progress) {
+		monteCarloSimulate(ctx, node, max_steps);
+		return true;
+	}
+
+	long double score = monteCarloScore(ctx, node);
+	search->best_score = std::max(search->best_score, score);
+	if (node->progress >= ctx.target_progress) {
+		storeLatestDeadend(ctx, node);
+	}
+	prior_visits = std::max(1, prior_visits);
+	propagateScore(ctx, node, score * prior_visits, score, prior_visits);
+	++search->total_playouts;
+	return true;
+}
+
+int seedFromNeighbours(const GameContext& ctx, HGAME_STATE root, const SolutionIndex& index, int k, int max_steps) {
+	int n_seeded = 0;
+	for (const SolutionIndexEntry* e : findNearestSolutions(index, ctx, k)) {
+		if (seedSequence(ctx, root, e->sol.actions.data(), (int)e->sol.actions.size(), max_steps)) {
+			++n_seeded;
+		}
+	}
+	return n_seeded;
+}
+
+int seedMacros(const GameContext& ctx, HGAME_STATE root, const std::vector<std::vector<ACTION>>& seeds, int max_steps, int prior_visits) {
+	std::vector<ACTION> played(root->step);
+	makeSequence(root, played.data(), (int)played.size());
+	int n_seeded = 0;
+	for (const std::vector<ACTION>& seed : seeds) {
+		if (seed.size() <= played.size() || !std::equal(played.begin(), played.end(), seed.begin())) {
+			continue;
+		}
+		if (seedSequence(ctx, root, seed.data() + played.size(), (int)(seed.size() - played.size()), max_steps, prior_visits)) {
+			++n_seeded;
+		}
+	}
+	return n_seeded;
+}
+
+HGAME_STATE playOpeningBook(const GameContext& ctx, HGAME_STATE root, const OpeningBook& book, int& n_moves) {
+	n_moves = 0;
+	int n_lines = 0;
+	const OpeningLine* lines = findOpenings(book, ctx, n_lines);
+	for (int i = 0; i < n_lines; ++i) {
+		HGAME_STATE node = root;
+		int played = 0;
+		for (; played < (int)lines[i].len; ++played) {
+			HGAME_STATE next = executeAction(ctx, node, (ACTION)lines[i].actions[played]);
+			if (!next.isValid()) {
+				break;
+			}
+			node = next;
+		}
+		if (played == (int)lines[i].len && node->durability > 0 && node->progress < ctx.target_progress) {
+			n_moves = played;
+			return node;
+		}
+		while (!(node == root)) {
+			HGAME_STATE parent = node->parent;
+			freeGameState(node);
+			node = parent;
+		}
+	}
+	return root;
+}
+
+const char* checkpoint_path = 0;
+int checkpoint_interval_sec = 300;
+volatile sig_atomic_t break_requested = 0;
+const char* stats_path = 0;
+int stats_interval_sec = 5;
+
+bool searchLimitsReached(const SearchLimits& limits) {
+	if (break_requested || (limits.cancel && limits.cancel->load(std::memory_order_relaxed))) {
+		return true;
+	}
+	return limits.deadline != std::chrono::steady_clock::time_point()
+		&& std::chrono::steady_clock::now() >= limits.deadline;
+}
+
+static bool searchStopRequested(int iteration) {
+	if (search->cancel && search->cancel->load(std::memory_order_relaxed)) {
+		return true;
+	}
+	// The clock is read every 256 iterations, a few ms at worst
+	return (iteration & 0xFF) == 0
+		&& search->deadline != std::chrono::steady_clock::time_point()
+		&& std::chrono::steady_clock::now() >= search->deadline;
+}
+
+static void reportProgress(int iteration, int n_iterations) {
+	const SolveParams* params = search->params;
+	if (!params || !params->on_progress || (iteration & 0xFF) != 0) {
+		return;
+	}
+	auto now = std::chrono::steady_clock::now();
+	if (now - search->last_progress < std::chrono::milliseconds(params->progress_interval_ms)) {
+		return;
+	}
+	search->last_progress = now;
+
+	SolveProgress p = {
+		.iteration = iteration,
+		.n_iterations = n_iterations,
+		.playouts = search->total_playouts
+	};
+	const HGAME_STATE best = search->last_deadend_state;
+	if (best.isValid()) {
+		p.has_best = true;
+		p.progress = best->progress;
+		p.quality = best->quality;
+		p.durability = best->durability;
+		p.cp = best->cp;
+		ACTION seq[TELEMETRY_MAX_MACRO_LEN];
+		p.best_macro.assign(seq, seq + makeSequence(best, seq, TELEMETRY_MAX_MACRO_LEN));
+	}
+	params->on_progress(p);
+}
+
+bool writeSearchCheckpoint(const GameContext& ctx, HGAME_STATE root, int n_iterations, int max_steps, float exploration_constant, float max_score_weight, int iteration, int n_useless_selections) {
+	std::ostringstream rng_state;
+	rng_state << search->rng;
+
+	SearchCheckpoint cp = {
+		.ctx = ctx,
+		.n_iterations = n_iterations,
+		.max_steps = max_steps,
+		.exploration_constant = exploration_constant,
+		.max_score_weight = max_score_weight,
+		.iteration = iteration,
+		.n_useless_selections = n_useless_selections,
+		.total_playouts = search->total_playouts,
+		.n_deleted_states = search->n_deleted_states,
+		.best_score = (double)search->best_score,
+		.root_idx = root.getIdx(),
+		.last_deadend_idx = search->last_deadend_state.getIdx(),
+		.combo_set_hash = comboSetHash(search->combos),
+		.rng_state = rng_state.str()
+	};
+	return saveCheckpoint(checkpoint_path, cp);
+}
+
+bool readSearchCheckpoint(const char* path, SearchCheckpoint& cp) {
+	if (!loadCheckpoint(path, cp)) {
+		return false;
+	}
+	if (cp.combo_set_hash != comboSetHash(search->combos)) {
+		printf("%s was searched with another combo set\n", path);
+		return false;
+	}
+	std::istringstream rng_state(cp.rng_state);
+	rng_state >> search->rng;
+
+	search->total_playouts = cp.total_playouts;
+	search->n_deleted_states = cp.n_deleted_states;
+	search->best_score = cp.best_score;
+	search->last_deadend_state = HGAME_STATE(cp.last_deadend_idx);
+	search->resume_iteration = cp.iteration;
+	search->resume_useless_selections = cp.n_useless_selections;
+	return true;
+}
+
+static void metricsRecordTree(HGAME_STATE state) {
+	for (HGAME_STATE child = state->first_child; child.isValid(); child = child->next_sibling) {
+		metricsRecordLiveNode(child->step);
+		metricsRecordTree(child);
+	}
+}
+
+MonteCarloResult monteCarloSearch2(const GameContext& ctx, HGAME_STATE state_, int n_iterations, int max_steps, float exploration_constant, float max_score_weight) {
+	if (search->resume_iteration == 0) {
+		search->total_playouts = 0;
+		search->n_deleted_states = 0;
+	}
+	metricsReset();
+	metricsRecordTree(state_);
+	/*
+	{
+		HGAME_STATE child = executeAction(ctx, state, ACTION::MUSCLE_MEMORY);
+		if (child.isValid()) {
+			state->children.push_back(child);
+			monteCarloSimulate(ctx, child);
+		}
+		child = executeAction(ctx, state, ACTION::REFLECT);
+		if (child.isValid()) {
+			state->children.push_back(child);
+			monteCarloSimulate(ctx, child);
+		}
+	}*/
+
+	int n_useless_selections = search->resume_useless_selections;
+	const int N_ITERATIONS = n_iterations;
+	HGAME_STATE st_selected = HGAME_STATE();
+	HGAME_STATE state = state_;
+	time_t last_checkpoint_time = time(0);
+	time_t last_stats_time = 0;
+	auto publishStats = [&](int iteration) {
+		MetricsSearchState snapshot = {
+			.iteration = iteration,
+			.n_iterations = N_ITERATIONS,
+			.playouts = search->total_playouts,
+			.n_deleted_states = search->n_deleted_states,
+			.best_score = (double)search->best_score
+		};
+		metricsPublish(stats_path, snapshot);
+	};
+	for(int i = search->resume_iteration; i < N_ITERATIONS; ++i) {
+		search->search_iteration = i;
+
+		// Clock reads and progress reports only every few thousand iterations
+		bool checkpoint_due = false;
+		if ((i & 0xFFF) == 0) {
+			TelemetryEvent e = {};
+			e.type = TE_PROGRESS;
+			e.iteration = i;
+			e.n_iterations = N_ITERATIONS;
+			fillTelemetryState(e, search->last_deadend_state, false);
+			telemetryPush(e);
+
+			time_t now = time(0);
+			checkpoint_due = checkpoint_path && now - last_checkpoint_time >= checkpoint_interval_sec;
+			if (stats_path && now - last_stats_time >= stats_interval_sec) {
+				publishStats(i);
+				last_stats_time = now;
+			}
+		}
+
+		if (searchStopRequested(i)) {
+			break;
+		}
+		reportProgress(i, N_ITERATIONS);
+		if (break_requested || checkpoint_due) {
+			if (checkpoint_path) {
+				TelemetryEvent e = {};
+				e.type = TE_CHECKPOINT;
+				e.iteration = i;
+				e.ok = writeSearchCheckpoint(ctx, state, n_iterations, max_steps, exploration_constant, max_score_weight, i, n_useless_selections);
+				telemetryPush(e);
+				last_checkpoint_time = time(0);
+			}
+			if (break_requested) {
+				break;
+			}
+		}
+
+		{
+			PROFILE_SCOPE(PP_SELECT);
+			st_selected = monteCarloSelect2(ctx, state, max_steps, exploration_constant, max_score_weight);
+		}
+
+		// Every line was pruned, nothing left to search
+		if (!st_selected.isValid()) {
+			break;
+		}
+		PROFILE_COUNT(PC_SELECT_DEPTH, st_selected->step);
+		metricsRecordSelect(st_selected->step);
+
+		if (st_selected->progress < ctx.target_progress && st_selected->durability <= 0) {
+			++n_useless_selections;
+			//long double score = 0;// monteCarloScore(ctx, st_selected);
+			//propagateScore(ctx, st_selected, score, score, 0);
+			continue;
+		}
+
+		if (st_selected->progress >= ctx.target_progress && st_selected->durability <= 0) {
+			++n_useless_selections;
+			//long double score = monteCarloScore(ctx, st_selected);
+			//propagateScore(st_selected, score, score, 0);
+			continue;
+		}
+
+		if (!monteCarloExpandAndSimulate2(ctx, st_selected, max_steps)) {
+			++n_useless_selections;
+			//--i;
+			continue;
+		}
+	}
+
+	if (stats_path) {
+		publishStats(search->search_iteration + 1);
+	}
+
+	st_selected = monteCarloSelect(ctx, state, max_steps, .0f, 1.0f);
+
+	return MonteCarloResult{ 
+		.best_leaf = st_selected, 
+		.useless_selection_ratio = n_useless_selections / ((float)N_ITERATIONS)
+	};
+}
+
+int countBadDeadends(const GameContext& ctx, HGAME_STATE state) {
+	if (!state->first_child.isValid() && state->n_possible_moves == 0) {
+		if (state->progress < ctx.target_progress) {
+			return 1;
+		}
+		if (state->progress >= ctx.target_progress
+			&& search->last_deadend_state.isValid()
+			&& search->last_deadend_state->progress >= ctx.target_progress
+			&& state->quality < search->last_deadend_state->quality
+			) {
+			return 1;
+		}
+	}
+
+	int count = 0;
+	for (HGAME_STATE ch = state->first_child; ch.isValid(); ch = ch->next_sibling) {
+		count += countBadDeadends(ctx, ch);
+	}
+	return count;
+}
+
+const std::vector<std::vector<ACTION>> reference_macros = {
+	{
+		MUSCLE_MEMORY,
+		WASTE_NOT_II,
+		MANIPULATION,
+		VENERATION,
+		GROUNDWORK,
+		GROUNDWORK,
+		DELICATE_SYNTHESIS,
+		GROUNDWORK,
+		PREPARATORY_TOUCH,
+		PREPARATORY_TOUCH,
+		TRAINED_PERFECTION,
+		INNOVATION,
+		PREPARATORY_TOUCH,
+		DELICATE_SYNTHESIS,
+		BASIC_TOUCH,
+		DELICATE_SYNTHESIS,
+		GREAT_STRIDES,
+		INNOVATION,
+		BYREGOTS_BLESSING,
+		BASIC_SYNTHESIS
+	},
+	{
+		MUSCLE_MEMORY,
+		VENERATION,
+		WASTE_NOT,
+		GROUNDWORK,
+		GROUNDWORK,
+		GROUNDWORK,
+		BASIC_TOUCH,
+		VENERATION,
+		DELICATE_SYNTHESIS,
+		IMMACULATE_MEND,
+		DELICATE_SYNTHESIS,
+		TRAINED_PERFECTION,
+		PREPARATORY_TOUCH,
+		INNOVATION,
+		PRUDENT_TOUCH,
+		STANDARD_TOUCH,
+		BASIC_TOUCH,
+		STANDARD_TOUCH,
+		INNOVATION,
+		BASIC_TOUCH,
+		GREAT_STRIDES,
+		BYREGOTS_BLESSING,
+		CAREFUL_SYNTHESIS,
+	},
+	{ // NOTE: Weird results: p: 7610/7500, q: 9834/16500, d: -5/70, cp: 3/598
+		MUSCLE_MEMORY,
+		TRAINED_PERFECTION,
+		VENERATION,
+		GROUNDWORK,
+		WASTE_NOT,
+		DELICATE_SYNTHESIS,
+		GROUNDWORK,
+		VENERATION,
+		DELICATE_SYNTHESIS,
+		DELICATE_SYNTHESIS,
+		DELICATE_SYNTHESIS,
+		BASIC_SYNTHESIS,
+		IMMACULATE_MEND,
+		INNOVATION,
+		PRUDENT_TOUCH,
+		BASIC_TOUCH,
+		STANDARD_TOUCH,
+		ADVANCED_TOUCH,
+		INNOVATION,
+		STANDARD_TOUCH,
+		ADVANCED_TOUCH,
+		GREAT_STRIDES,
+		BYREGOTS_BLESSING,
+		BASIC_SYNTHESIS,
+	},
+	{
+		MUSCLE_MEMORY,
+		GROUNDWORK,
+		MASTERS_MEND,
+		WASTE_NOT_II,
+		TRAINED_PERFECTION,
+		VENERATION,
+		GROUNDWORK,
+		DELICATE_SYNTHESIS,
+		DELICATE_SYNTHESIS,
+		GROUNDWORK,
+		WASTE_NOT,
+		INNOVATION,
+		PREPARATORY_TOUCH,
+		PREPARATORY_TOUCH,
+		STANDARD_TOUCH,
+		ADVANCED_TOUCH,
+		VENERATION,
+		PRUDENT_SYNTHESIS,
+		CAREFUL_SYNTHESIS,
+	}
+};
+
+void testScoring(const GameContext& ctx, HGAME_STATE state_) {
+	for (const std::vector<ACTION>& m : reference_macros) {
+		HGAME_STATE st = executeSequence(ctx, state_, 45, m.data(), (int)m.size());
+		long double score = monteCarloScore(ctx, st);
+		st->score = score;
+		printState(ctx, st);
+	}
+}
+
+HGAME_STATE replayCachedSolution(const GameContext& ctx, const char* cache_dir, int n_iterations) {
+	CachedSolution sol;
+	if (!solutionCacheLoad(cache_dir, ctx, sol) || sol.actions.empty() || sol.n_iterations < n_iterations) {
+		return HGAME_STATE();
+	}
+	int len = (int)sol.actions.size();
+	HGAME_STATE root = createGameState(GameState());
+	initGameState(ctx, *root);
+	HGAME_STATE last = executeSequence(ctx, root, len, sol.actions.data(), len);
+	if (!last.isValid() || last->step != len
+		|| last->progress != sol.progress || last->quality != sol.quality
+		|| last->durability != sol.durability || last->cp != sol.cp) {
+		return HGAME_STATE();
+	}
+	return last;
+}
+
+Solver::Solver(GameStatePool* pool)
+	: pool(pool) {}
+
+Solver::Solver(int pool_size)
+	: pool(createGameStatePool(pool_size)) {}
+
+Solver::~Solver() {
+	destroyGameStatePool(pool);
+}
+
+SolverScope::SolverScope(Solver& solver) {
+	prev_pool = bindGameStatePool(solver.getPool());
+	prev_search = search;
+	search = &solver.getSearchState();
+}
+
+SolverScope::~SolverScope() {
+	bindGameStatePool(prev_pool);
+	search = prev_search;
+}
+
+static void fillSolveResult(const GameContext& ctx, const HGAME_STATE best, SolveResult& result) {
+	ACTION seq[TELEMETRY_MAX_MACRO_LEN];
+	int len = makeSequence(best, seq, TELEMETRY_MAX_MACRO_LEN);
+	result.found = best->progress >= ctx.target_progress;
+	result.actions.assign(seq, seq + len);
+	result.progress = best->progress;
+	result.quality = best->quality;
+	result.durability = best->durability;
+	result.cp = best->cp;
+}
+
+bool improveSolution(const GameContext& ctx, std::vector<ACTION>& macro, int fixed, int max_steps, int budget_ms, GameState& end) {
+	if (budget_ms <= 0 || fixed >= (int)macro.size()) {
+		return false;
+	}
+	GameState start{};
+	initGameState(ctx, start);
+	for (int i = 0; i < fixed; ++i) {
+		if (!canExecuteAction(ctx, start, macro[i])) {
+			return false;
+		}
+		++start.step;
+		applyAction(ctx, start, macro[i]);
+	}
+	std::vector<ACTION> tail(macro.begin() + fixed, macro.end());
+	ImproveParams params = { .max_steps = max_steps, .time_budget_ms = budget_ms };
+	if (!improveMacro(ctx, start, tail, params, end)) {
+		return false;
+	}
+	macro.resize(fixed);
+	macro.insert(macro.end(), tail.begin(), tail.end());
+	return true;
+}
+
+static void improveResult(const GameContext& ctx, const SolveParams& params, int fixed, SolveResult& result) {
+	GameState end{};
+	if (!result.found || !improveSolution(ctx, result.actions, fixed, params.max_steps, params.improve_ms, end)) {
+		return;
+	}
+	result.progress = end.progress;
+	result.quality = end.quality;
+	result.durability = end.durability;
+	result.cp = end.cp;
+	result.improved = true;
+}
+
+HGAME_STATE solveByPhasesFrom(const GameContext& ctx, HGAME_STATE root, int max_steps, int beam_width) {
+	PhaseSolveParams params = { .max_steps = max_steps, .beam_width = beam_width };
+	std::vector<ACTION> plan;
+	if (!solveByPhases(ctx, progressOracle(ctx), *root, params, plan)) {
+		return HGAME_STATE();
+	}
+	HGAME_STATE end = executeSequence(ctx, root, max_steps, plan.data(), (int)plan.size());
+	if (!end.isValid() || end->progress < ctx.target_progress) {
+		return HGAME_STATE();
+	}
+	return end;
+}
+
+HGAME_STATE solveByNrpaFrom(const GameContext& ctx, HGAME_STATE root, const SolveParams& params, int& playouts) {
+	NrpaParams nrpa = {
+		.level = params.nrpa_level,
+		.iterations = params.nrpa_iterations,
+		.max_steps = params.max_steps,
+		.n_threads = params.engine_threads,
+		.limits = { .cancel = params.cancel, .deadline = params.deadline, .incumbent = params.incumbent }
+	};
+	NrpaResult r = solveByNrpa(ctx, progressOracle(ctx), *root, nrpa);
+	playouts = r.playouts;
+	if (!r.found) {
+		return HGAME_STATE();
+	}
+	HGAME_STATE end = executeSequence(ctx, root, params.max_steps, r.actions.data(), (int)r.actions.size());
+	if (!end.isValid() || end->progress < ctx.target_progress) {
+		return HGAME_STATE();
+	}
+	return end;
+}
+
+HGAME_STATE solveByGeneticFrom(const GameContext& ctx, HGAME_STATE root, const SolveParams& params, int& playouts) {
+	GeneticParams ga = {
+		.population = params.ga_population,
+		.generations = params.ga_generations,
+		.max_steps = params.max_steps,
+		.n_threads = params.engine_threads,
+		.limits = { .cancel = params.cancel, .deadline = params.deadline, .incumbent = params.incumbent }
+	};
+	GeneticResult r = solveByGenetic(ctx, progressOracle(ctx), *root, ga);
+	playouts = r.evaluations;
+	if (!r.found) {
+		return HGAME_STATE();
+	}
+	HGAME_STATE end = executeSequence(ctx, root, params.max_steps, r.actions.data(), (int)r.actions.size());
+	if (!end.isValid() || end->progress < ctx.target_progress) {
+		return HGAME_STATE();
+	}
+	return end;
+}
+
+HGAME_STATE solveByLdsFrom(const GameContext& ctx, HGAME_STATE root, const SolveParams& params, int& playouts) {
+	LdsParams lds = {
+		.max_discrepancies = params.lds_discrepancies,
+		.width = params.lds_width,
+		.max_steps = params.max_steps,
+		.n_threads = params.engine_threads,
+		.limits = { .cancel = params.cancel, .deadline = params.deadline, .incumbent = params.incumbent }
+	};
+	LdsResult r = solveByLds(ctx, progressOracle(ctx), *root, lds);
+	playouts = r.lines;
+	if (!r.found) {
+		return HGAME_STATE();
+	}
+	HGAME_STATE end = executeSequence(ctx, root, params.max_steps, r.actions.data(), (int)r.actions.size());
+	if (!end.isValid() || end->progress < ctx.target_progress) {
+		return HGAME_STATE();
+	}
+	return end;
+}
+
+SolveResult Solver::solve(const GameContext& ctx, const SolveParams& params) {
+	SolverScope scope(*this);
+	resetGameStatePool();
+	search.last_deadend_state = HGAME_STATE();
+	search.best_score = .0L;
+	search.best_macro_id = 0;
+	search.resume_iteration = 0;
+	search.resume_useless_selections = 0;
+
+	SolveResult result;
+	const bool use_cache = params.cache_dir && params.prefix.empty();
+	if (use_cache) {
+		HGAME_STATE hit = replayCachedSolution(ctx, params.cache_dir, params.n_iterations);
+		if (hit.isValid()) {
+			search.last_deadend_state = hit;
+			result.from_cache = true;
+			// Stored macros were polished before they went in, and a hit has to stay cheap
+			fillSolveResult(ctx, hit, result);
+			return result;
+		}
+		resetGameStatePool();
+	}
+
+	HGAME_STATE root = createGameState(GameState());
+	initGameState(ctx, *root);
+	for (ACTION a : params.prefix) {
+		HGAME_STATE next = executeAction(ctx, root, a);
+		if (!next.isValid()) {
+			result.prefix_ok = false;
+			return result;
+		}
+		root = next;
+	}
+	const bool at_start = params.prefix.empty();
+	bool store_result = false;
+	if (params.book && at_start) {
+		root = playOpeningBook(ctx, root, *params.book, result.book_moves);
+	}
+
+	// Stats too low for the craft, no engine can get anywhere
+	if (root->progress < ctx.target_progress && !canStillFinish(progressOracle(ctx), *root, params.max_steps - root->step)) {
+		return result;
+	}
+	// A prefix that already finishes the craft leaves nothing to search
+	if (root->durability <= 0 || root->progress >= ctx.target_progress) {
+		search.last_deadend_state = root;
+	} else if (params.engine == ENGINE_PHASES) {
+		search.last_deadend_state = solveByPhasesFrom(ctx, root, params.max_steps, params.phase_beam_width);
+	} else if (params.engine == ENGINE_NRPA) {
+		search.last_deadend_state = solveByNrpaFrom(ctx, root, params, result.playouts);
+	} else if (params.engine == ENGINE_GA) {
+		search.last_deadend_state = solveByGeneticFrom(ctx, root, params, result.playouts);
+	} else if (params.engine == ENGINE_LDS) {
+		search.last_deadend_state = solveByLdsFrom(ctx, root, params, result.playouts);
+	} else {
+		search.cancel = params.cancel;
+		search.deadline = params.deadline;
+		search.params = &params;
+		search.combos = params.combos;
+		search.rave_equivalence = params.rave_equivalence;
+		search.last_progress = {};
+		if (params.warm_start && at_start && !result.book_moves) {
+			seedFromNeighbours(ctx, root, *params.warm_start, params.warm_start_k, params.max_steps);
+		}
+		seedMacros(ctx, root, params.seeds, params.max_steps, params.seed_visits);
+		MonteCarloResult mc = monteCarloSearch2(ctx, root, params.n_iterations, params.max_steps, params.exploration_constant, params.max_score_weight);
+		search.cancel = 0;
+		search.deadline = {};
+		search.params = 0;
+		search.combos = 0;
+		search.rave_equivalence = 0.f;
+		result.playouts = search.total_playouts;
+		result.useless_selection_ratio = mc.useless_selection_ratio;
+
+		// Only a search that used its whole budget is worth remembering
+		bool stopped_early = break_requested
+			|| (params.cancel && params.cancel->load(std::memory_order_relaxed))
+			|| (params.deadline != std::chrono::steady_clock::time_point() && std::chrono::steady_clock::now() >= params.deadline);
+		store_result = use_cache && !stopped_early;
+	}
+	if (!search.last_deadend_state.isValid()) {
+		return result;
+	}
+
+	fillSolveResult(ctx, search.last_deadend_state, result);
+	// Prefix and book moves stay as they are
+	improveResult(ctx, params, root->step, result);
+	if (store_result && result.found) {
+		CachedSolution sol = {
+			.actions = result.actions,
+			.progress = result.progress,
+			.quality = result.quality,
+			.durability = result.durability,
+			.cp = result.cp,
+			.n_iterations = params.n_iterations
+		};
+		solutionCacheStore(params.cache_dir, ctx, sol);
+	}
+	if (params.incumbent && result.found) {
+		raiseIncumbent(*params.incumbent, result.quality);
+	}
+	return result;
+}
+
+void SolveHandle::cancel() {
+	if (cancel_token) {
+		cancel_token->store(true, std::memory_order_relaxed);
+	}
+}
+
+bool SolveHandle::isDone() const {
+	return !result.valid() || result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+SolveResult SolveHandle::get() {
+	return result.get();
+}
+
+SolveHandle solveAsync(Solver& solver, const GameContext& ctx, SolveParams params) {
+	SolveHandle handle;
+	handle.cancel_token = std::make_shared<std::atomic<bool>>(false);
+	params.cancel = handle.cancel_token.get();
+	// The token is captured too, so it outlives the search even if the handle is moved from
+	handle.result = std::async(std::launch::async, [&solver, ctx, params = std::move(params), token = handle.cancel_token]() {
+		return solver.solve(ctx, params);
+	});
+	return handle;
+}
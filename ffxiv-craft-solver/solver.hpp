@@ -0,0 +1,341 @@
+#pragma once
+
+#include <signal.h>
+#include <time.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <random>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "actions.hpp"
+#include "game_state_handle.hpp"
+#include "checkpoint.hpp"
+#include "solution_cache.hpp"
+#include "opening_book.hpp"
+#include "combo_set.hpp"
+#include "endgame_table.hpp"
+#include "progress_oracle.hpp"
+#include "phase_solver.hpp"
+#include "nrpa.hpp"
+#include "genetic.hpp"
+#include "lds.hpp"
+#include "macro_improver.hpp"
+
+
+// Process-wide settings for the single-search command line mode.
+// Batch workers leave checkpoint_path and stats_path unset
+extern const char* checkpoint_path;
+extern int checkpoint_interval_sec;
+extern volatile sig_atomic_t break_requested;
+// True once break_requested, the cancel token or the deadline of 'limits' says to stop
+bool searchLimitsReached(const SearchLimits& limits);
+extern const char* stats_path;
+extern int stats_interval_sec;
+// Shared read-only by every search, rollouts finish from it once they reach its range
+extern const EndgameTable* endgame_table;
+
+
+void initGameState(const GameContext& cfg, GameState& state);
+bool canExecuteAction(const GameContext& ctx, const GameState& state, ACTION action_idx);
+// Applies an executable action to 'state' in place, stepping effects like a game turn.
+// Doesn't touch step or parent, executeAction does that for pooled states
+void applyAction(const GameContext& ctx, GameState& state, ACTION action_idx, bool verbose = false);
+HGAME_STATE executeAction(const GameContext& ctx, HGAME_STATE hstate, ACTION action_idx, bool verbose = false);
+HGAME_STATE executeSequence(const GameContext& ctx, HGAME_STATE state, int max_step, const ACTION* seq, int seq_len, bool verbose = false);
+HGAME_STATE executeRandomSequence(const GameContext& ctx, HGAME_STATE state, int max_step, int max_seq, int& total_durability_spent);
+// Plays the endgame table's finisher for 'state', numbering the new states' combo_depth from
+// 'combo_depth' on. Returns the finished state, or an invalid handle with nothing left allocated
+// if there is no table, 'state' is out of its range or the finisher doesn't carry over to ctx
+HGAME_STATE finishFromEndgameTable(const GameContext& ctx, HGAME_STATE state, int max_step, int combo_depth);
+
+void deleteBranch(HGAME_STATE state);
+HGAME_STATE copyBranch(HGAME_STATE state, bool keep_score = false);
+HGAME_STATE freeComboBranch(HGAME_STATE state);
+int makeSequence(HGAME_STATE state, ACTION* seq, int max_len);
+// In-game macro text, split into parts of 14 lines like printMacro
+std::string formatMacro(const ACTION* seq, int len);
+
+void printMacro(const HGAME_STATE state);
+void printActionArray(const HGAME_STATE state);
+void printState(const GameContext& ctx, const HGAME_STATE state);
+void printProgressBar(int value, int total);
+void printElapsed(float sec);
+
+bool storeLatestDeadend(const GameContext& ctx, HGAME_STATE state);
+
+void assignActionWeights(const GameContext& ctx, const GameState& state, float* weights);
+void assignActionWeights(const GameContext& ctx, HGAME_STATE state, float* weights);
+int selectRandomAction(const GameContext& ctx, HGAME_STATE state, float* weights);
+int selectBestAction(const GameContext& ctx, HGAME_STATE state, float* weights);
+
+void removeFromSequence(ACTION* seq, int len, int remove_at);
+void fillRandomSequence(ACTION* seq, int len);
+
+void propagateScore(const GameContext& ctx, HGAME_STATE state, long double eval, long double max_score, int visits);
+long double monteCarloScore(const GameContext& ctx, HGAME_STATE state);
+long double monteCarloScore(const GameContext& ctx, const GameState& state);
+
+void findSolution(const GameContext& ctx, HGAME_STATE state, int max_step);
+void findSolutionWithCombos(const GameContext& ctx, HGAME_STATE state, int max_step);
+void monteCarloSearch(const GameContext& ctx, HGAME_STATE state, int depth = 0);
+
+struct MonteCarloResult {
+	HGAME_STATE best_leaf;
+	float useless_selection_ratio;
+};
+
+MonteCarloResult monteCarloSearch2(const GameContext& ctx, HGAME_STATE state_, int n_iterations, int max_steps, float exploration_constant, float max_score_weight);
+int countBadDeadends(const GameContext& ctx, HGAME_STATE state);
+// Hand-written lines that score well on the default craft
+extern const std::vector<std::vector<ACTION>> reference_macros;
+void testScoring(const GameContext& ctx, HGAME_STATE state_);
+
+// Fails unless SearchState::combos is the set the checkpoint was written with
+bool readSearchCheckpoint(const char* path, SearchCheckpoint& cp);
+
+// Grafts a known macro into the tree below root, reusing nodes already there. A finished
+// macro is backed up as if it had been played out prior_visits times and becomes the
+// incumbent if it beats it. An action that no longer executes under ctx cuts the macro short,
+// and an unfinished macro is completed by a rollout. Returns false if nothing executed
+bool seedSequence(const GameContext& ctx, HGAME_STATE root, const ACTION* seq, int len, int max_steps, int prior_visits = 1);
+// Seeds the macros of the k nearest solved crafts, returns how many took
+int seedFromNeighbours(const GameContext& ctx, HGAME_STATE root, const SolutionIndex& index, int k, int max_steps);
+// Macros start at the beginning of the craft, so below a root already some moves in (a prefix or
+// book moves) only those that open with the same moves are grafted, from where they diverge.
+// Returns how many took
+int seedMacros(const GameContext& ctx, HGAME_STATE root, const std::vector<std::vector<ACTION>>& seeds, int max_steps, int prior_visits);
+
+// Local-search post-pass over a finished macro, leaving its first 'fixed' actions alone.
+// Returns true and fills 'end' if it found a better one
+bool improveSolution(const GameContext& ctx, std::vector<ACTION>& macro, int fixed, int max_steps, int budget_ms, GameState& end);
+
+// Runs the phase-decomposed planner from root and replays its plan in the pool.
+// Returns the finished state, or an invalid handle if no plan finishes the craft
+HGAME_STATE solveByPhasesFrom(const GameContext& ctx, HGAME_STATE root, int max_steps, int beam_width);
+
+// Plays the best book line for the class of ctx that executes in full without ending the
+// craft and returns the state it leads to, or root if there is none
+HGAME_STATE playOpeningBook(const GameContext& ctx, HGAME_STATE root, const OpeningBook& book, int& n_moves);
+
+// Replays the cached macro for 'ctx' from a fresh root. Returns its final state,
+// or an invalid handle on a miss or when the macro no longer reproduces what was stored
+// Entries from a smaller search budget than 'n_iterations' count as misses
+HGAME_STATE replayCachedSolution(const GameContext& ctx, const char* cache_dir, int n_iterations);
+
+
+// Snapshot handed to SolveParams::on_progress
+struct SolveProgress {
+	int iteration;
+	int n_iterations;
+	int playouts;
+	bool has_best;			// Fields below are only meaningful once a craft was finished
+	int progress;
+	int quality;
+	int durability;
+	int cp;
+	std::vector<ACTION> best_macro;
+};
+
+enum SOLVE_ENGINE {
+	ENGINE_MCTS,
+	ENGINE_PHASES,	// Phase-decomposed planner, see phase_solver.hpp. Ignores the search budget
+	ENGINE_NRPA,	// Nested Rollout Policy Adaptation, see nrpa.hpp. Budgeted by its level and iterations
+	ENGINE_GA,		// Genetic algorithm, see genetic.hpp. Budgeted by its generations
+	ENGINE_LDS		// Limited discrepancy search, see lds.hpp. Budgeted by its discrepancies
+};
+
+inline bool engineFromString(const char* name, SOLVE_ENGINE& out) {
+	if (!strcmp(name, "mcts")) {
+		out = ENGINE_MCTS;
+	} else if (!strcmp(name, "phases")) {
+		out = ENGINE_PHASES;
+	} else if (!strcmp(name, "nrpa")) {
+		out = ENGINE_NRPA;
+	} else if (!strcmp(name, "ga")) {
+		out = ENGINE_GA;
+	} else if (!strcmp(name, "lds")) {
+		out = ENGINE_LDS;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+inline const char* engineName(SOLVE_ENGINE engine) {
+	switch (engine) {
+	case ENGINE_PHASES: return "phases";
+	case ENGINE_NRPA: return "nrpa";
+	case ENGINE_GA: return "ga";
+	case ENGINE_LDS: return "lds";
+	default: return "mcts";
+	}
+}
+
+struct SolveParams {
+	SOLVE_ENGINE engine = ENGINE_MCTS;
+	int phase_beam_width = 512;
+	int nrpa_level = 3;
+	int nrpa_iterations = 100;
+	int ga_population = 256;
+	int ga_generations = 200;
+	int lds_discrepancies = 3;
+	int lds_width = 3;
+	int engine_threads = 1;	// NRPA, GA and LDS parallelize a single search over this many threads
+	int n_iterations = 2'000'000;
+	int max_steps = 26;
+	float exploration_constant = 3.0f;
+	float max_score_weight = 0.3f;
+	// RAVE: visits at which a child's own average and its all-moves-as-first one weigh the
+	// same in MCTS selection, the AMAF share fades as sqrt(k / (3n + k)). 0 turns it off
+	float rave_equivalence = 0.f;
+
+	// Optional early stop, the search returns the best craft found so far
+	const std::atomic<bool>* cancel = 0;
+	std::chrono::steady_clock::time_point deadline = {};	// Epoch means none
+	// Best quality a portfolio of engines has finished the craft with, -1 before any.
+	// Raised on every finished craft and used to drop branches that can't beat it, see portfolio.hpp
+	std::atomic<int>* incumbent = 0;
+
+	// Actions forced at the start, the search continues from where they leave off
+	std::vector<ACTION> prefix;
+
+	// Solution cache directory. Hits skip the search, full searches that finish a craft
+	// are stored. Not used with a prefix
+	const char* cache_dir = 0;
+	// Book moves are played before searching. Not used with a prefix
+	const OpeningBook* book = 0;
+	// Seeds the tree with macros of similar solved crafts. Not used with a prefix
+	const SolutionIndex* warm_start = 0;
+	int warm_start_k = 4;
+	// Learned combos MCTS may expand as single edges. Other engines ignore it
+	const ComboSet* combos = 0;
+	// Known macros from the start of the craft, grafted below the search root before the first
+	// iteration. With a prefix or book moves only those opening the same way, see seedMacros
+	std::vector<std::vector<ACTION>> seeds;
+	int seed_visits = 8;
+
+	// Local-search post-pass over the found macro, see macro_improver.hpp. 0 turns it off.
+	// Cache hits skip it, the stored macro already went through it
+	int improve_ms = 20;
+
+	// Called on the search thread, at most once per progress_interval_ms
+	std::function<void(const SolveProgress&)> on_progress;
+	int progress_interval_ms = 250;
+};
+
+struct SolveResult {
+	bool found = false;		// Some sequence reached target_progress
+	bool prefix_ok = true;	// False if a prefix action could not be executed
+	bool from_cache = false;
+	int book_moves = 0;		// Leading actions taken from the opening book
+	bool improved = false;	// The post-pass changed the macro the search found
+	std::vector<ACTION> actions;
+	int progress = 0;
+	int quality = 0;
+	int durability = 0;
+	int cp = 0;
+	int playouts = 0;
+	float useless_selection_ratio = .0f;
+};
+
+// Runs NRPA from root with the engine settings, cancel token and deadline of 'params' and
+// replays its best sequence in the pool. Returns the final state, invalid if nothing finished
+HGAME_STATE solveByNrpaFrom(const GameContext& ctx, HGAME_STATE root, const SolveParams& params, int& playouts);
+// Same for the genetic algorithm, 'playouts' counts genome evaluations
+HGAME_STATE solveByGeneticFrom(const GameContext& ctx, HGAME_STATE root, const SolveParams& params, int& playouts);
+// Same for limited discrepancy search, 'playouts' counts lines followed to their end
+HGAME_STATE solveByLdsFrom(const GameContext& ctx, HGAME_STATE root, const SolveParams& params, int& playouts);
+
+// Working state of one search, owned by a Solver. The engine functions above
+// reach it through the solver bound to the calling thread, see SolverScope
+struct SearchState {
+	HGAME_STATE last_deadend_state;	// Best finished craft so far
+	long double best_score = .0L;
+	int best_macro_id = 0;
+	int search_iteration = 0;
+	int total_playouts = 0;
+	int n_deleted_states = 0;
+
+	// Set when restoring from a checkpoint, monteCarloSearch2 continues from here
+	int resume_iteration = 0;
+	int resume_useless_selections = 0;
+
+	// Set by solve() for the duration of one search
+	const std::atomic<bool>* cancel = 0;
+	std::chrono::steady_clock::time_point deadline = {};
+	const SolveParams* params = 0;
+	std::chrono::steady_clock::time_point last_progress = {};
+	// Learned combos the expansion tries before primitive actions, set by solve() or the caller
+	const ComboSet* combos = 0;
+	// See SolveParams::rave_equivalence, set the same way
+	float rave_equivalence = 0.f;
+
+	std::mt19937 rng{ std::random_device{}() };
+	time_t last_branch_report = 0;
+
+	// Built for the craft being searched on first use
+	ProgressOracle progress_oracle;
+};
+
+// A self-contained solver: its own node pool, RNG, incumbent and counters.
+// Any number can exist, each used by one thread at a time
+class Solver {
+public:
+	// Takes ownership of the pool
+	explicit Solver(GameStatePool* pool);
+	explicit Solver(int pool_size);
+	~Solver();
+	Solver(const Solver&) = delete;
+	Solver& operator=(const Solver&) = delete;
+
+	// One-shot search. The pool is reset first, so a solver can be reused job after job
+	SolveResult solve(const GameContext& ctx, const SolveParams& params);
+
+	GameStatePool* getPool() { return pool; }
+	SearchState& getSearchState() { return search; }
+
+private:
+	GameStatePool* pool;
+	SearchState search;
+};
+
+// A solve running on its own thread. Dropping the handle waits for the search,
+// so cancel() first to abandon it
+class SolveHandle {
+public:
+	SolveHandle() = default;
+	SolveHandle(SolveHandle&&) = default;
+	SolveHandle& operator=(SolveHandle&&) = default;
+
+	// Cooperative: the search stops within one iteration and still reports its best so far
+	void cancel();
+	bool isDone() const;
+	// Blocks until the search ends. Can be called once
+	SolveResult get();
+
+private:
+	friend SolveHandle solveAsync(Solver& solver, const GameContext& ctx, SolveParams params);
+
+	std::shared_ptr<std::atomic<bool>> cancel_token;
+	std::future<SolveResult> result;
+};
+
+// The solver must not be touched by anyone else until the handle is done.
+// A cancel token already set in params is replaced by the handle's
+SolveHandle solveAsync(Solver& solver, const GameContext& ctx, SolveParams params);
+
+// Binds a solver to the calling thread for the lifetime of the scope,
+// for driving the engine functions directly. Scopes nest
+class SolverScope {
+	GameStatePool* prev_pool;
+	SearchState* prev_search;
+public:
+	SolverScope(Solver& solver);
+	~SolverScope();
+	SolverScope(const SolverScope&) = delete;
+	SolverScope& operator=(const SolverScope&) = delete;
+};
@@ -0,0 +1,219 @@
+#include "solver_api.h"
+
+#include <algorithm>
+#include <memory>
+#include <new>
+#include "action_enum.hpp"
+#include "solver.hpp"
+
+
+struct fcs_solver {
+	Solver solver;
+
+	fcs_solver(int pool_size)
+		: solver(pool_size) {}
+};
+
+fcs_solver* fcs_solver_create(int pool_size) {
+	if (pool_size <= 0) {
+		return 0;
+	}
+	try {
+		return new fcs_solver(pool_size);
+	} catch (const std::bad_alloc&) {
+		return 0;
+	}
+}
+
+void fcs_solver_destroy(fcs_solver* solver) {
+	delete solver;
+}
+
+void fcs_params_default(fcs_params* params) {
+	SolveParams defaults;
+	*params = fcs_params{
+		.n_iterations = defaults.n_iterations,
+		.max_steps = defaults.max_steps,
+		.exploration_constant = defaults.exploration_constant,
+		.max_score_weight = defaults.max_score_weight,
+		.deadline_ms = 0,
+		.prefix = 0,
+		.prefix_len = 0,
+		.progress_interval_ms = defaults.progress_interval_ms,
+		.seeds = 0,
+		.seed_lens = 0,
+		.n_seeds = 0,
+		.seed_visits = defaults.seed_visits
+	};
+}
+
+static bool convertRequest(const fcs_craft* craft, const fcs_params* params, GameContext& ctx, SolveParams& sp) {
+	if (!craft || !params || params->prefix_len < 0 || params->n_seeds < 0
+		|| (params->prefix_len > 0 && !params->prefix)
+		|| (params->n_seeds > 0 && (!params->seeds || !params->seed_lens))) {
+		return false;
+	}
+	ctx = GameContext{
+		.base_progress_increase = craft->base_progress,
+		.base_quality_increase = craft->base_quality,
+		.max_cp = craft->max_cp,
+		.target_progress = craft->target_progress,
+		.target_quality = craft->target_quality,
+		.max_durability = craft->max_durability
+	};
+	sp.n_iterations = params->n_iterations;
+	sp.max_steps = std::min(params->max_steps, FCS_MAX_ACTIONS);
+	sp.exploration_constant = params->exploration_constant;
+	sp.max_score_weight = params->max_score_weight;
+	if (params->deadline_ms > 0) {
+		sp.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(params->deadline_ms);
+	}
+	for (int i = 0; i < params->prefix_len; ++i) {
+		if (params->prefix[i] < 0 || params->prefix[i] >= ACTION_COUNT) {
+			return false;
+		}
+		sp.prefix.push_back((ACTION)params->prefix[i]);
+	}
+	for (int i = 0; i < params->n_seeds; ++i) {
+		if (params->seed_lens[i] < 0 || (params->seed_lens[i] > 0 && !params->seeds[i])) {
+			return false;
+		}
+		std::vector<ACTION> seed;
+		for (int j = 0; j < params->seed_lens[i]; ++j) {
+			if (params->seeds[i][j] < 0 || params->seeds[i][j] >= ACTION_COUNT) {
+				return false;
+			}
+			seed.push_back((ACTION)params->seeds[i][j]);
+		}
+		sp.seeds.push_back(seed);
+	}
+	sp.seed_visits = params->seed_visits;
+	sp.progress_interval_ms = params->progress_interval_ms;
+	return true;
+}
+
+static int convertResult(const SolveResult& r, fcs_result* result) {
+	if (!r.prefix_ok) {
+		return FCS_ERR_PREFIX;
+	}
+	*result = fcs_result{
+		.found = r.found,
+		.progress = r.progress,
+		.quality = r.quality,
+		.durability = r.durability,
+		.cp = r.cp,
+		.playouts = r.playouts,
+		.n_actions = std::min((int)r.actions.size(), FCS_MAX_ACTIONS)
+	};
+	for (int i = 0; i < result->n_actions; ++i) {
+		result->actions[i] = r.actions[i];
+	}
+	return FCS_OK;
+}
+
+int fcs_solve(fcs_solver* solver, const fcs_craft* craft, const fcs_params* params, fcs_result* result) {
+	GameContext ctx;
+	SolveParams sp;
+	if (!solver || !result || !convertRequest(craft, params, ctx, sp)) {
+		return FCS_ERR_ARGUMENT;
+	}
+	// Nothing may unwind into C callers
+	try {
+		return convertResult(solver->solver.solve(ctx, sp), result);
+	} catch (const std::bad_alloc&) {
+		return FCS_ERR_MEMORY;
+	} catch (...) {
+		return FCS_ERR_INTERNAL;
+	}
+}
+
+struct fcs_job {
+	SolveHandle handle;
+	bool waited = false;
+};
+
+fcs_job* fcs_solve_async(fcs_solver* solver, const fcs_craft* craft, const fcs_params* params, fcs_progress_fn on_progress, void* user_data) {
+	GameContext ctx;
+	SolveParams sp;
+	if (!solver || !convertRequest(craft, params, ctx, sp)) {
+		return 0;
+	}
+	if (on_progress) {
+		sp.on_progress = [on_progress, user_data](const SolveProgress& p) {
+			fcs_progress out = {
+				.iteration = p.iteration,
+				.n_iterations = p.n_iterations,
+				.playouts = p.playouts,
+				.has_best = p.has_best,
+				.progress = p.progress,
+				.quality = p.quality,
+				.durability = p.durability,
+				.cp = p.cp,
+				.n_actions = std::min((int)p.best_macro.size(), FCS_MAX_ACTIONS)
+			};
+			for (int i = 0; i < out.n_actions; ++i) {
+				out.actions[i] = p.best_macro[i];
+			}
+			on_progress(&out, user_data);
+		};
+	}
+	try {
+		// Owned here until returned, solveAsync throws if no thread can be started
+		std::unique_ptr<fcs_job> job(new fcs_job);
+		job->handle = solveAsync(solver->solver, ctx, std::move(sp));
+		return job.release();
+	} catch (...) {
+		return 0;
+	}
+}
+
+void fcs_job_cancel(fcs_job* job) {
+	if (job) {
+		job->handle.cancel();
+	}
+}
+
+int fcs_job_done(fcs_job* job) {
+	return job && job->handle.isDone();
+}
+
+int fcs_job_wait(fcs_job* job, fcs_result* result) {
+	if (!job || !result || job->waited) {
+		return FCS_ERR_ARGUMENT;
+	}
+	job->waited = true;
+	try {
+		return convertResult(job->handle.get(), result);
+	} catch (const std::bad_alloc&) {
+		return FCS_ERR_MEMORY;
+	} catch (...) {
+		return FCS_ERR_INTERNAL;
+	}
+}
+
+void fcs_job_free(fcs_job* job) {
+	if (!job) {
+		return;
+	}
+	job->handle.cancel();
+	delete job;
+}
+
+int fcs_action_count(void) {
+	return ACTION_COUNT;
+}
+
+const char* fcs_action_name(int action) {
+	if (action < 0 || action >= ACTION_COUNT) {
+		return 0;
+	}
+	return actionToString((ACTION)action);
+}
+
+int fcs_action_from_name(const char* name) {
+	ACTION a;
+	if (!name || !actionFromString(name, a)) {
+		return -1;
+	}
+	return a;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+// C interface to the solver, for embedding it in other processes and languages.
+// Build the engine sources (everything but main.cpp) together with solver_api.cpp
+// as a static or shared library; define FCS_BUILD_DLL when building a Windows DLL.
+// A solver handle must not be used by two threads at once, separate handles
+// are fully independent
+
+#ifdef _WIN32
+#ifdef FCS_BUILD_DLL
+#define FCS_API __declspec(dllexport)
+#else
+#define FCS_API
+#endif
+#else
+#define FCS_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FCS_MAX_ACTIONS 64
+
+typedef struct fcs_solver fcs_solver;
+
+typedef struct fcs_craft {
+	int base_progress;
+	int base_quality;
+	int max_cp;
+	int target_progress;
+	int target_quality;
+	int max_durability;
+} fcs_craft;
+
+typedef struct fcs_params {
+	int n_iterations;
+	int max_steps;
+	float exploration_constant;
+	float max_score_weight;
+	int deadline_ms;		/* 0 means none */
+	const int* prefix;		/* Actions forced at the start, may be null */
+	int prefix_len;
+	int progress_interval_ms;	/* Async solves only */
+	const int* const* seeds;	/* Known macros grafted into the tree before searching, may be null */
+	const int* seed_lens;
+	int n_seeds;
+	int seed_visits;		/* Prior playouts credited to each finished seed */
+} fcs_params;
+
+typedef struct fcs_result {
+	int found;
+	int progress;
+	int quality;
+	int durability;
+	int cp;
+	int playouts;
+	int n_actions;
+	int actions[FCS_MAX_ACTIONS];
+} fcs_result;
+
+typedef struct fcs_progress {
+	int iteration;
+	int n_iterations;
+	int playouts;
+	int has_best;			/* Fields below are only meaningful once a craft was finished */
+	int progress;
+	int quality;
+	int durability;
+	int cp;
+	int n_actions;
+	int actions[FCS_MAX_ACTIONS];
+} fcs_progress;
+
+/* Called on the search thread */
+typedef void (*fcs_progress_fn)(const fcs_progress* progress, void* user_data);
+
+typedef struct fcs_job fcs_job;
+
+enum {
+	FCS_OK = 0,
+	FCS_ERR_ARGUMENT = -1,
+	FCS_ERR_PREFIX = -2,	/* A prefix action could not be executed */
+	FCS_ERR_MEMORY = -3,
+	FCS_ERR_INTERNAL = -4	/* The search failed some other way, e.g. a thread could not be started */
+};
+
+/* Returns null if the pool can't be allocated */
+FCS_API fcs_solver* fcs_solver_create(int pool_size);
+FCS_API void fcs_solver_destroy(fcs_solver* solver);
+
+FCS_API void fcs_params_default(fcs_params* params);
+FCS_API int fcs_solve(fcs_solver* solver, const fcs_craft* craft, const fcs_params* params, fcs_result* result);
+
+/* Runs the solve on its own thread; the solver is busy until the job is freed.
+   Returns null on bad arguments or if the job can't be started. on_progress may be null */
+FCS_API fcs_job* fcs_solve_async(fcs_solver* solver, const fcs_craft* craft, const fcs_params* params, fcs_progress_fn on_progress, void* user_data);
+/* The search stops within one iteration; waiting still yields the best craft so far */
+FCS_API void fcs_job_cancel(fcs_job* job);
+FCS_API int fcs_job_done(fcs_job* job);
+/* Blocks until the search ends. Returns the same codes as fcs_solve, at most once per job */
+FCS_API int fcs_job_wait(fcs_job* job, fcs_result* result);
+/* Cancels the search if still running and waits for it */
+FCS_API void fcs_job_free(fcs_job* job);
+
+/* Action ids are the ACTION enum values. Returns null / -1 when out of range / unknown */
+FCS_API int fcs_action_count(void);
+FCS_API const char* fcs_action_name(int action);
+FCS_API int fcs_action_from_name(const char* name);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,229 @@
+#include "telemetry.hpp"
+
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "action_enum.hpp"
+#include "actions.hpp"
+
+
+// Bounded MPMC queue (Vyukov). Each cell carries a sequence number telling
+// producers and the consumer whose turn it is, so neither side ever locks
+template<typename T, int CAPACITY>
+class RingBuffer {
+	static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+	struct Cell {
+		std::atomic<size_t> seq;
+		T data;
+	};
+
+	Cell cells[CAPACITY];
+	alignas(64) std::atomic<size_t> enqueue_pos;
+	alignas(64) std::atomic<size_t> dequeue_pos;
+
+public:
+	RingBuffer() {
+		for (int i = 0; i < CAPACITY; ++i) {
+			cells[i].seq.store(i, std::memory_order_relaxed);
+		}
+		enqueue_pos.store(0, std::memory_order_relaxed);
+		dequeue_pos.store(0, std::memory_order_relaxed);
+	}
+
+	bool push(const T& value) {
+		size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+		for (;;) {
+			Cell& cell = cells[pos & (CAPACITY - 1)];
+			size_t seq = cell.seq.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+			if (diff == 0) {
+				if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					cell.data = value;
+					cell.seq.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			} else if (diff < 0) {
+				return false;
+			} else {
+				pos = enqueue_pos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	bool pop(T& value) {
+		size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+		for (;;) {
+			Cell& cell = cells[pos & (CAPACITY - 1)];
+			size_t seq = cell.seq.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+			if (diff == 0) {
+				if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					value = cell.data;
+					cell.seq.store(pos + CAPACITY, std::memory_order_release);
+					return true;
+				}
+			} else if (diff < 0) {
+				return false;
+			} else {
+				pos = dequeue_pos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+};
+
+
+static RingBuffer<TelemetryEvent, 4096> ring;
+static std::atomic<bool> running = false;
+static std::atomic<int> n_dropped = 0;
+static std::thread reporter;
+static TELEMETRY_OUTPUT output_kind = TO_CONSOLE;
+static FILE* out = 0;
+
+static void printConsoleProgress(const TelemetryEvent& e) {
+	float ratio = e.n_iterations ? e.iteration / (float)e.n_iterations : .0f;
+	const int max_blocks = 50;
+	printf("[");
+	for (int i = 0; i < max_blocks; ++i) {
+		printf(i / (float)max_blocks < ratio ? "#" : " ");
+	}
+	printf("] %i%%, %i/%i | best #%i score: %.6f p: %i q: %i d: %i cp: %i | states: %i\n",
+		(int)(ratio * 100), e.iteration, e.n_iterations,
+		e.best_macro_id, e.best_score,
+		e.progress, e.quality, e.durability, e.cp,
+		e.pool_occupancy
+	);
+}
+
+static void printConsoleMacro(const char* title, const TelemetryEvent& e) {
+	printf("%s #%i at iteration %i: step %i, p: %i, q: %i, d: %i, cp: %i\n\t",
+		title, e.best_macro_id, e.iteration, e.step, e.progress, e.quality, e.durability, e.cp
+	);
+	for (int i = 0; i < e.macro_len; ++i) {
+		printf("%s%s", i ? ", " : "", actions[e.macro[i]].name);
+	}
+	printf("\n");
+}
+
+static void writeJsonl(const TelemetryEvent& e) {
+	static const char* type_names[] = { "progress", "new_best", "checkpoint", "branch" };
+	fprintf(out, "{\"type\":\"%s\",\"iteration\":%i,\"n_iterations\":%i,\"best_macro_id\":%i,\"best_score\":%.6f,"
+		"\"pool_occupancy\":%i,\"progress\":%i,\"quality\":%i,\"durability\":%i,\"cp\":%i,\"step\":%i",
+		type_names[e.type], e.iteration, e.n_iterations, e.best_macro_id, e.best_score,
+		e.pool_occupancy, e.progress, e.quality, e.durability, e.cp, e.step
+	);
+	if (e.type == TE_CHECKPOINT) {
+		fprintf(out, ",\"ok\":%s", e.ok ? "true" : "false");
+	}
+	if (e.macro_len) {
+		fprintf(out, ",\"macro\":[");
+		for (int i = 0; i < e.macro_len; ++i) {
+			fprintf(out, "%s\"%s\"", i ? "," : "", actionToString((ACTION)e.macro[i]));
+		}
+		fprintf(out, "]");
+	}
+	fprintf(out, "}\n");
+}
+
+static void reporterLoop() {
+	using clock = std::chrono::steady_clock;
+	// Console output is throttled to what a human can read; JSONL gets everything
+	const auto console_interval = std::chrono::seconds(1);
+	auto last_progress_print = clock::time_point();
+	auto last_best_print = clock::time_point();
+	TelemetryEvent pending_progress{};
+	TelemetryEvent pending_best;
+	bool has_pending_progress = false;
+	bool has_pending_best = false;
+
+	for (;;) {
+		bool stopping = !running.load(std::memory_order_acquire);
+		TelemetryEvent e;
+		int n_popped = 0;
+		while (ring.pop(e)) {
+			++n_popped;
+			if (output_kind == TO_JSONL) {
+				writeJsonl(e);
+				continue;
+			}
+			switch (e.type) {
+			case TE_PROGRESS: pending_progress = e; has_pending_progress = true; break;
+			case TE_NEW_BEST: pending_best = e; has_pending_best = true; break;
+			case TE_CHECKPOINT:
+				printf(e.ok ? "Checkpoint written at iteration %i\n" : "Failed to write checkpoint at iteration %i\n", e.iteration);
+				break;
+			case TE_BRANCH:
+				printConsoleMacro("Branch", e);
+				break;
+			}
+		}
+
+		auto now = clock::now();
+		if (has_pending_best && (stopping || now - last_best_print >= console_interval)) {
+			printConsoleMacro("New best", pending_best);
+			has_pending_best = false;
+			last_best_print = now;
+		}
+		if (has_pending_progress && (stopping || now - last_progress_print >= console_interval)) {
+			printConsoleProgress(pending_progress);
+			has_pending_progress = false;
+			last_progress_print = now;
+		}
+		if (n_popped) {
+			fflush(out);
+		}
+
+		if (stopping) {
+			break;
+		}
+		if (!n_popped) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		}
+	}
+
+	if (n_dropped) {
+		fprintf(stderr, "telemetry: %i events dropped\n", n_dropped.load());
+	}
+}
+
+bool telemetryStart(TELEMETRY_OUTPUT output, const char* path) {
+	if (running) {
+		return false;
+	}
+	output_kind = output;
+	out = stdout;
+	if (output == TO_JSONL) {
+		out = fopen(path, "w");
+		if (!out) {
+			return false;
+		}
+	}
+	running = true;
+	reporter = std::thread(reporterLoop);
+	return true;
+}
+
+void telemetryStop() {
+	if (!running) {
+		return;
+	}
+	running.store(false, std::memory_order_release);
+	reporter.join();
+	if (out && out != stdout) {
+		fclose(out);
+	}
+	out = 0;
+}
+
+bool telemetryPush(const TelemetryEvent& e) {
+	// Batch workers run without a reporter, their events are simply discarded
+	if (!running.load(std::memory_order_relaxed)) {
+		return false;
+	}
+	if (!ring.push(e)) {
+		n_dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	return true;
+}
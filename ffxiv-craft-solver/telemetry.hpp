@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+
+
+constexpr int TELEMETRY_MAX_MACRO_LEN = 64;
+
+enum TELEMETRY_EVENT {
+	TE_PROGRESS,		// Periodic heartbeat from the search loop
+	TE_NEW_BEST,		// Incumbent improved, macro is filled in
+	TE_CHECKPOINT,		// Checkpoint written (ok != 0) or failed
+	TE_BRANCH			// Branch picked by the legacy monteCarloSearch, macro is filled in
+};
+
+struct TelemetryEvent {
+	uint8_t type;
+	uint8_t ok;
+	uint8_t macro_len;
+
+	int32_t iteration;
+	int32_t n_iterations;
+	int32_t best_macro_id;
+	int32_t pool_occupancy;
+	float best_score;
+
+	int32_t progress;
+	int32_t quality;
+	int32_t durability;
+	int32_t cp;
+	int32_t step;
+
+	uint8_t macro[TELEMETRY_MAX_MACRO_LEN];
+};
+
+enum TELEMETRY_OUTPUT {
+	TO_CONSOLE,
+	TO_JSONL
+};
+
+// Starts the reporter thread. For TO_JSONL 'path' is the output file
+bool telemetryStart(TELEMETRY_OUTPUT output, const char* path = 0);
+// Drains whatever is still queued and joins the reporter
+void telemetryStop();
+
+// Lock-free and never blocks, safe from any number of search threads.
+// Returns false and drops the event if the ring is full
+bool telemetryPush(const TelemetryEvent& e);
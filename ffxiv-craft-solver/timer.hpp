@@ -1,5 +1,5 @@
-#pragma once
-
-
-void timerBegin();
-float timerEnd();
+#pragma once
+
+
+void timerBegin();
+float timerEnd();
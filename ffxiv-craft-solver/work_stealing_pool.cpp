@@ -0,0 +1,97 @@
+#include "work_stealing_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+
+WorkStealingPool::WorkStealingPool(int n_threads, std::function<void(int worker)> on_thread_start)
+	: on_thread_start(on_thread_start) {
+	n_threads = std::max(1, n_threads);
+	for (int i = 0; i < n_threads; ++i) {
+		queues.push_back(std::make_unique<WorkerQueue>());
+	}
+	for (int i = 0; i < n_threads; ++i) {
+		workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+	}
+}
+
+WorkStealingPool::~WorkStealingPool() {
+	{
+		std::lock_guard<std::mutex> lock(idle_mutex);
+		stopping = true;
+	}
+	idle_cv.notify_all();
+	for (auto& t : workers) {
+		t.join();
+	}
+}
+
+void WorkStealingPool::submit(Task task) {
+	int q = next_queue.fetch_add(1, std::memory_order_relaxed) % (int)queues.size();
+	// Counted before it can be picked up, or a worker could finish it and
+	// take n_pending below zero, past a wait() that never gets notified
+	{
+		std::lock_guard<std::mutex> lock(idle_mutex);
+		++n_pending;
+	}
+	{
+		std::lock_guard<std::mutex> lock(queues[q]->mutex);
+		queues[q]->tasks.push_back(std::move(task));
+	}
+	idle_cv.notify_all();
+}
+
+void WorkStealingPool::wait() {
+	std::unique_lock<std::mutex> lock(idle_mutex);
+	done_cv.wait(lock, [this]() { return n_pending == 0; });
+}
+
+bool WorkStealingPool::popLocal(int worker, Task& task) {
+	WorkerQueue& q = *queues[worker];
+	std::lock_guard<std::mutex> lock(q.mutex);
+	if (q.tasks.empty()) {
+		return false;
+	}
+	task = std::move(q.tasks.front());
+	q.tasks.pop_front();
+	return true;
+}
+
+bool WorkStealingPool::steal(int thief, Task& task) {
+	int n = (int)queues.size();
+	for (int i = 1; i < n; ++i) {
+		WorkerQueue& q = *queues[(thief + i) % n];
+		std::lock_guard<std::mutex> lock(q.mutex);
+		if (!q.tasks.empty()) {
+			task = std::move(q.tasks.back());
+			q.tasks.pop_back();
+			return true;
+		}
+	}
+	return false;
+}
+
+void WorkStealingPool::workerLoop(int worker) {
+	if (on_thread_start) {
+		on_thread_start(worker);
+	}
+	for (;;) {
+		Task task;
+		if (popLocal(worker, task) || steal(worker, task)) {
+			task(worker);
+			std::lock_guard<std::mutex> lock(idle_mutex);
+			if (--n_pending == 0) {
+				done_cv.notify_all();
+			}
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(idle_mutex);
+		if (stopping) {
+			return;
+		}
+		// n_pending also counts tasks being run elsewhere, so this can wake
+		// spuriously; the loop just finds nothing to steal and sleeps again
+		idle_cv.wait_for(lock, std::chrono::milliseconds(50));
+	}
+}
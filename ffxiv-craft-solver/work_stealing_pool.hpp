@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// Fixed set of workers, each with its own task deque. A worker pops its own
+// tasks from the front and, when it runs dry, steals from the back of another
+// worker's deque. Tasks are whole solves (seconds each), so a mutex per deque
+// is plenty; the point is keeping every core busy with uneven job lengths
+class WorkStealingPool {
+public:
+	typedef std::function<void(int worker)> Task;
+
+	// on_thread_start runs once on each worker before any task, e.g. to set up per-thread arenas
+	WorkStealingPool(int n_threads, std::function<void(int worker)> on_thread_start = nullptr);
+	~WorkStealingPool();
+
+	// Round-robins tasks over the workers' deques
+	void submit(Task task);
+	// Blocks until every submitted task has finished
+	void wait();
+
+	int threadCount() const { return (int)workers.size(); }
+
+private:
+	struct WorkerQueue {
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	bool popLocal(int worker, Task& task);
+	bool steal(int thief, Task& task);
+	void workerLoop(int worker);
+
+	std::vector<std::unique_ptr<WorkerQueue>> queues;
+	std::vector<std::thread> workers;
+	std::function<void(int)> on_thread_start;
+
+	std::mutex idle_mutex;
+	std::condition_variable idle_cv;
+	std::condition_variable done_cv;
+	std::atomic<int> n_pending = 0;
+	std::atomic<int> next_queue = 0;
+	bool stopping = false;
+};